@@ -3,85 +3,246 @@
 
 #include <cstdint>
 #include <chrono>
+#include <vector>
+#include <atomic>
+#include <stdexcept>
 #include "src/order/order.h"
 #include "src/packets/packets.h"
 #include "benchmark/source/source.h"
 #include "benchmark/destination/destination.h"
 #include "benchmark/stats.h"
+#include "benchmark/schedule.h"
 #include "benchmark/static_map.h"
+#include "src/utility/spsc.h"
 
 namespace piex {
 namespace benchmark {
 
+// room for a window of outstanding requests and the request submitted past it, rounded up to a power of 2
+constexpr std::size_t ring_size(std::size_t window) {
+	std::size_t size = 1;
+	while (size < window + 2) {
+		size <<= 1;
+	}
+	return size;
+}
+
+/// \remarks Feeds requests from a source to a destination and measures the latency of each until its response. The closed loop submits as fast as the window of outstanding requests allows, the open loop submits at the times fixed by a `Schedule` and measures from them, so that a stalled destination is charged for the requests it delayed, not only for those in flight.
 class Benchmark {
 public:
+	/// \effects Run closed-loop: submit whenever at most `PIEX_OPTION_BENCHMARK_REQUEST_WINDOW_SIZE` requests are outstanding
 	void start(
 		source::Source<Benchmark> *source,
 		destination::Destination<Benchmark> *destination,
 		std::uint64_t requests_total)
 	{
+		bind(source, destination);
+		run({this}, requests_total);
+	}
+
+	/// \effects Run open-loop: submit each request at its intended time in `schedule`, or as soon as possible once late
+	/// \remarks `stats` measures from the intended send times and `uncorrected_stats` from the actual ones. The window still bounds outstanding requests, but time stalled on it counts towards the corrected latencies
+	void start(
+		source::Source<Benchmark> *source,
+		destination::Destination<Benchmark> *destination,
+		std::uint64_t requests_total,
+		Schedule schedule)
+	{
+		bind(source, destination);
+		run({this}, requests_total, &schedule);
+	}
+
+	/// \effects Set the source and destination of `run`
+	/// \requires `source` shall yield to this benchmark and `destination` shall respond to it
+	void bind(source::Source<Benchmark> *source, destination::Destination<Benchmark> *destination) {
+		source_ = source;
 		destination_ = destination;
-		requests_submitted_ = 0;
-		requests_processed_ = 0;
-		stats_.start();
+	}
+
+	/// \effects Run bound benchmarks on the calling thread, submitting `requests_total` requests to them in turn, closed-loop if `schedule` is null and open-loop otherwise
+	/// \remarks The window is per benchmark. Each keeps its own stats, to be merged by the caller
+	static void run(const std::vector<Benchmark *> &group, std::uint64_t requests_total, Schedule *schedule = nullptr) {
+		for (Benchmark *benchmark : group) {
+			benchmark->reset(schedule != nullptr);
+		}
+		Clock::time_point begin = Clock::now();
+		Clock::time_point intended_time;
+		bool scheduled = false;
+		std::uint64_t requests_submitted = 0;
+		std::size_t next = 0;
 
-		while (requests_submitted_  < requests_total) {
-			if (requests_submitted_ - requests_processed_ > PIEX_OPTION_BENCHMARK_REQUEST_WINDOW_SIZE) {
-				destination_->flush();
+		while (requests_submitted < requests_total) {
+			Benchmark &benchmark = *group[next];
+			next = (next + 1) % group.size();
+			if (schedule && !scheduled) {
+				intended_time = begin + std::chrono::duration_cast<Clock::duration>(schedule->next());
+				scheduled = true;
+				if (Clock::now() < intended_time) {
+					// ahead of schedule: send what is buffered and handle responses until the request is due
+					for (Benchmark *other : group) {
+						other->destination_->flush();
+					}
+					while (Clock::now() < intended_time) {
+						for (Benchmark *other : group) {
+							other->destination_->poll();
+						}
+					}
+				}
+			}
+			benchmark.intended_time_ = intended_time;
+			if (benchmark.outstanding() > PIEX_OPTION_BENCHMARK_REQUEST_WINDOW_SIZE) {
+				benchmark.destination_->flush();
 			}
-			while (requests_submitted_ - requests_processed_ > PIEX_OPTION_BENCHMARK_REQUEST_WINDOW_SIZE) {
-				destination_->wait_response();
+			while (benchmark.outstanding() > PIEX_OPTION_BENCHMARK_REQUEST_WINDOW_SIZE) {
+				benchmark.destination_->wait_response();
+			}
+			// sources may yield nothing, e.g. a cancel with an empty book, which keeps the intended time for the next
+			std::uint64_t before = benchmark.requests_submitted_;
+			benchmark.source_->yield();
+			if (benchmark.requests_submitted_ != before) {
+				++requests_submitted;
+				scheduled = false;
 			}
-			source->yield();
 		}
-		destination_->flush();
-		while (requests_submitted_ > requests_processed_) {
-			destination_->wait_response();
+		for (Benchmark *benchmark : group) {
+			benchmark->finish();
 		}
-		stats_.end();
 	}
+
 	void process(const Request::Place &request) {
 		++requests_submitted_;
-		place_time_.insert(request.order().id(), std::chrono::high_resolution_clock::now());
+#if PIEX_OPTION_BENCHMARK_RECEIVER_THREAD
+		push(sent());
+#else
+		place_time_.insert(request.order().id(), sent());
+#endif
 		destination_->process(request);
 	}
 	void process(const Request::Cancel &request) {
 		++requests_submitted_;
-		cancel_time_.insert(request.id(), std::chrono::high_resolution_clock::now());
+#if PIEX_OPTION_BENCHMARK_RECEIVER_THREAD
+		push(sent());
+#else
+		cancel_time_.insert(request.id(), sent());
+#endif
 		destination_->process(request);
 	}
-	void process(const Response::Place &response) {
-		++requests_processed_;
-		stats_.add_entry(elapsed_time(place_time_.erase(response.id())));
+	/// \remarks With `PIEX_OPTION_BENCHMARK_RECEIVER_THREAD`, responses may be processed by another thread than requests
+	void process([[maybe_unused]] const Response::Place &response) {
+#if PIEX_OPTION_BENCHMARK_RECEIVER_THREAD
+		record(pop());
+#else
+		record(place_time_.erase(response.id()));
+#endif
+		processed();
 	}
-	void process(const Response::Cancel &response) {
-		++requests_processed_;
-		stats_.add_entry(elapsed_time(cancel_time_.erase(response.id())));
+	void process([[maybe_unused]] const Response::Cancel &response) {
+#if PIEX_OPTION_BENCHMARK_RECEIVER_THREAD
+		record(pop());
+#else
+		record(cancel_time_.erase(response.id()));
+#endif
+		processed();
 	}
 	void process(const Response::Match &) {}
+	/// \returns Latencies from the intended send times, the same as `uncorrected_stats` in closed loop
 	const Stats &stats() {
 		return stats_;
 	}
+	/// \returns Latencies from the actual send times
+	const Stats &uncorrected_stats() {
+		return uncorrected_stats_;
+	}
 private:
+	using Clock = std::chrono::high_resolution_clock;
+	struct SendTime {
+		Clock::time_point intended;
+		Clock::time_point actual;
+	};
+
+	source::Source<Benchmark> *source_;
 	destination::Destination<Benchmark> *destination_;
-	std::uint64_t requests_submitted_, requests_processed_;
+	std::uint64_t requests_submitted_;
+	// written by the thread processing responses, released once their latencies are recorded
+	std::atomic<std::uint64_t> requests_processed_;
+	bool open_loop_;
+	Clock::time_point intended_time_;
 	Stats stats_;
+	Stats uncorrected_stats_;
+#if PIEX_OPTION_BENCHMARK_RECEIVER_THREAD
+	// servers respond in request order, so send times are handed to the receiving thread in that order rather than looked up by id
+	utility::spsc::Ring<SendTime, ring_size(PIEX_OPTION_BENCHMARK_REQUEST_WINDOW_SIZE)> send_times_;
+#else
 	static_map<
 		Order::IdType,
-		std::chrono::high_resolution_clock::time_point,
+		SendTime,
 		PIEX_OPTION_BENCHMARK_REQUEST_WINDOW_SIZE,
 		true
 	> place_time_;
 	static_map<
 		Order::IdType,
-		std::chrono::high_resolution_clock::time_point,
+		SendTime,
 		PIEX_OPTION_BENCHMARK_REQUEST_WINDOW_SIZE,
 		false
 	> cancel_time_;
+#endif
+
+	void reset(bool open_loop) {
+		requests_submitted_ = 0;
+		requests_processed_ = 0;
+		open_loop_ = open_loop;
+		stats_.start();
+		uncorrected_stats_.start();
+	}
+
+	std::uint64_t outstanding() const {
+		return requests_submitted_ - requests_processed_.load(std::memory_order_acquire);
+	}
+
+	void processed() {
+		requests_processed_.store(requests_processed_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	void finish() {
+		destination_->flush();
+		while (outstanding() > 0) {
+			destination_->wait_response();
+		}
+		stats_.end();
+		uncorrected_stats_.end();
+	}
+
+	SendTime sent() {
+		Clock::time_point now = Clock::now();
+		return SendTime{open_loop_ ? intended_time_ : now, now};
+	}
+
+	void record(const SendTime &time) {
+		Clock::time_point now = Clock::now();
+		stats_.add_entry(elapsed_time(time.intended, now));
+		uncorrected_stats_.add_entry(elapsed_time(time.actual, now));
+	}
+
+#if PIEX_OPTION_BENCHMARK_RECEIVER_THREAD
+	void push(const SendTime &time) {
+		SendTime *slot = send_times_.reserve();
+		if (!slot) {
+			throw std::logic_error("too many outstanding requests");
+		}
+		*slot = time;
+		send_times_.publish();
+	}
+
+	SendTime pop() {
+		SendTime time = *send_times_.front();
+		send_times_.pop();
+		return time;
+	}
+#endif
 
-	// elapsed time in 10^(-4) s
-	static std::uint64_t elapsed_time(std::chrono::high_resolution_clock::time_point tp) {
-		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - tp).count() / 100;
+	// elapsed time in ns
+	static std::uint64_t elapsed_time(Clock::time_point from, Clock::time_point to) {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
 	}
 
 };
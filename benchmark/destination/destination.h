@@ -14,6 +14,8 @@ public:
 	virtual void process(const Request::Place &request) = 0;
 	virtual void process(const Request::Cancel &request) = 0;
 	virtual void wait_response() {}
+	// handle responses already received without blocking
+	virtual void poll() {}
 	virtual void flush() {}
 };
 
@@ -2,7 +2,7 @@
 #define PIEX_HEADER_BENCHMARK_DESTINATION_EXCHANGE
 
 #include "src/packets/packets.h"
-#include "src/exchange/exchange.h"
+#include "src/exchange/market.h"
 
 namespace piex {
 namespace benchmark {
@@ -11,12 +11,12 @@ namespace destination {
 template <class Handler>
 class Exchange : public Destination<Handler> {
 public:
-	Exchange(Handler &handler) : handler_(handler), exchange_(*this) {}
+	Exchange(Handler &handler) : handler_(handler), market_(*this) {}
 	void process(const Request::Place &request) {
-		exchange_.process_request(request);
+		market_.process_request(request);
 	}
 	void process(const Request::Cancel &request) {
-		exchange_.process_request(request);
+		market_.process_request(request);
 	}
 	void on_place(const Response::Place &response) {
 		handler_.process(response);
@@ -29,7 +29,7 @@ public:
 	}
 private:
 	Handler &handler_;
-	piex::Exchange<Exchange> exchange_;
+	piex::Market<Exchange> market_;
 };
 
 }
@@ -2,37 +2,35 @@
 #define PIEX_HEADER_BENCHMARK_DESTINATION_FILE
 
 #include <string>
-#include <fstream>
-#include <stdexcept>
 #include "src/packets/packets.h"
 #include "benchmark/destination/destination.h"
+#include "benchmark/workload.h"
 
 namespace piex {
 namespace benchmark {
 namespace destination {
 
+/// \remarks Records requests into a workload file, which is complete once flushed
 template <class Handler>
 class File : public Destination<Handler> {
 public:
-	File(Handler &handler, const std::string path) :
+	File(Handler &handler, const std::string path, const workload::Parameters &parameters) :
 		handler_(handler),
-		file_(path, std::ios_base::out | std::ios_base::binary)
-	{
-		if (!file_.is_open()) {
-			throw std::invalid_argument("cannot open file \"" + path + "\"");
-		}
-	}
+		writer_(path.c_str(), parameters) {}
 	void process(const Request::Place &request) {
-		file_.write(reinterpret_cast<const char *>(&request), sizeof(request));
-		handler_.process(Response::Place{true, request.order().id()});
+		writer_.append(request);
+		handler_.process(Response::Place{true, request.order().id(), request.instrument()});
 	}
 	void process(const Request::Cancel &request) {
-		file_.write(reinterpret_cast<const char *>(&request), sizeof(request));
-		handler_.process(Response::Cancel{true, request.id()});
+		writer_.append(request);
+		handler_.process(Response::Cancel{true, request.id(), request.instrument()});
+	}
+	void flush() {
+		writer_.flush();
 	}
 private:
 	Handler &handler_;
-	std::ofstream file_;
+	workload::Writer writer_;
 };
 
 }
@@ -1,38 +1,75 @@
 #ifndef PIEX_HEADER_BENCHMARK_DESTINATION_SERVER
 #define PIEX_HEADER_BENCHMARK_DESTINATION_SERVER
 
+#include <atomic>
+#include <thread>
+#include <exception>
 #include "src/packets/packets.h"
 #include "src/client/client.h"
+#if PIEX_OPTION_BENCHMARK_RECEIVER_THREAD
+#include "src/nsemaphore/nsemaphore.h"
+#endif
 
 namespace piex {
 namespace benchmark {
 namespace destination {
 
+/// \remarks With `PIEX_OPTION_BENCHMARK_RECEIVER_THREAD`, responses are received and handed to `Handler` by a thread of their own, so that the sending thread never polls the socket and responses are timed as soon as they arrive. The receiving thread only blocks on the socket while requests are outstanding, and sleeps on an nsemaphore of `PIEX_OPTION_NSEMAPHORE` otherwise.
 template <class Handler>
 class Server : public Destination<Handler> {
 public:
 	Server(Handler &handler, const char *host, const char *port) : handler_(handler), client_(*this) {
 		client_.connect(host, port);
+#if PIEX_OPTION_BENCHMARK_RECEIVER_THREAD
+		receiver_ = std::thread([this] {
+			receive();
+		});
+#endif
+	}
+#if PIEX_OPTION_BENCHMARK_RECEIVER_THREAD
+	/// \requires All responses shall have been received, or the connection lost
+	~Server() {
+		outstanding_.terminate();
+		receiver_.join();
 	}
+#endif
 	void process(const Request::Place &request) {
 		client_.process(request);
-		client_.try_receive_responses();
+		sent();
 	}
 	void process(const Request::Cancel &request) {
 		client_.process(request);
-		client_.try_receive_responses();
+		sent();
 	}
 	void wait_response() {
+#if PIEX_OPTION_BENCHMARK_RECEIVER_THREAD
+		check();
+		std::this_thread::yield();
+#else
 		client_.receive_response();
+#endif
+	}
+	void poll() {
+#if PIEX_OPTION_BENCHMARK_RECEIVER_THREAD
+		check();
+#else
+		client_.try_receive_responses();
+#endif
 	}
 	void flush() {
 		client_.flush();
 	}
 	void on_place(const Response::Place &response) {
 		handler_.process(response);
+#if PIEX_OPTION_BENCHMARK_RECEIVER_THREAD
+		outstanding_.consume(1);
+#endif
 	}
 	void on_cancel(const Response::Cancel &response) {
 		handler_.process(response);
+#if PIEX_OPTION_BENCHMARK_RECEIVER_THREAD
+		outstanding_.consume(1);
+#endif
 	}
 	void on_match(const Response::Match &response) {
 		handler_.process(response);
@@ -40,6 +77,46 @@ public:
 private:
 	Handler &handler_;
 	piex::Client<Server> client_;
+#if PIEX_OPTION_BENCHMARK_RECEIVER_THREAD
+	// requests sent and not yet responded
+	nsemaphore::Strict outstanding_{0};
+	std::thread receiver_;
+	std::atomic<bool> failed_{false};
+	std::exception_ptr error_;
+
+	void receive() {
+		try {
+			while (true) {
+				outstanding_.wait(1);
+				if (outstanding_.load() == 0) {
+					// terminated
+					return;
+				}
+				client_.receive_response();
+			}
+		} catch (...) {
+			error_ = std::current_exception();
+			failed_.store(true, std::memory_order_release);
+		}
+	}
+
+	// rethrow errors of the receiving thread in the sending one
+	void check() {
+		if (failed_.load(std::memory_order_acquire)) {
+			std::rethrow_exception(error_);
+		}
+	}
+#endif
+
+	// count the request just sent, or receive available responses on the sending thread
+	void sent() {
+#if PIEX_OPTION_BENCHMARK_RECEIVER_THREAD
+		outstanding_.post(1);
+		check();
+#else
+		client_.try_receive_responses();
+#endif
+	}
 };
 
 }
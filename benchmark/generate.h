@@ -0,0 +1,130 @@
+#ifndef PIEX_HEADER_BENCHMARK_GENERATE
+#define PIEX_HEADER_BENCHMARK_GENERATE
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <exception>
+#include <stdexcept>
+#include "src/packets/packets.h"
+#include "src/order/order.h"
+#include "benchmark/workload.h"
+#include "benchmark/source/generator.h"
+
+namespace piex {
+namespace benchmark {
+namespace generate {
+
+// shards are interleaved in blocks of that many requests, so that threads do not write to the same cache lines
+constexpr std::uint64_t SHARD_BLOCK_SIZE = 64;
+
+/// \remarks Receives the requests of one shard and stores them in their slots: block `b` of shard `k` out of `n` is block `b * n + k` of the workload
+class Shard {
+public:
+	Shard(char *requests, std::uint64_t shard, std::uint64_t shards) : requests_(requests), shard_(shard), shards_(shards) {}
+
+	/// \returns The number of requests of shard `shard` in a workload of `count` requests
+	static std::uint64_t size(std::uint64_t count, std::uint64_t shard, std::uint64_t shards) {
+		std::uint64_t round = SHARD_BLOCK_SIZE * shards;
+		std::uint64_t rest = count % round;
+		std::uint64_t offset = shard * SHARD_BLOCK_SIZE;
+		return count / round * SHARD_BLOCK_SIZE + (rest > offset ? std::min(rest - offset, SHARD_BLOCK_SIZE) : 0);
+	}
+
+	// requests are rebuilt from their fields in the zero-filled slots, so that padding bytes are zero rather than whatever the stack held
+	void process(const Request::Place &request) {
+		new (next()) Request::Place(request.order_type(), request.order().id(), request.order().price(), request.order().quantity(), request.instrument());
+	}
+	void process(const Request::Cancel &request) {
+		new (next()) Request::Cancel(request.order_type(), request.id(), request.instrument());
+	}
+	std::uint64_t size() const {
+		return size_;
+	}
+private:
+	char *requests_;
+	const std::uint64_t shard_, shards_;
+	std::uint64_t size_ = 0;
+
+	char *next() {
+		std::uint64_t index = (size_ / SHARD_BLOCK_SIZE * shards_ + shard_) * SHARD_BLOCK_SIZE + size_ % SHARD_BLOCK_SIZE;
+		++size_;
+		return requests_ + index * workload::slot();
+	}
+};
+
+/// \effects Generate a workload of `count` requests of `profile` into the file at `path` on `threads` threads
+/// \remarks Thread `k` generates the instruments `k`, `k + threads`, ... with ids from `k * count` and a seed derived from `seed` and `k`, into every `threads`-th block of slots from `k`. The file is the same for the same arguments, whatever the scheduling.
+/// \requires `threads` shall not be greater than `instruments`
+inline void generate(const char *path, std::uint64_t book_size, std::uint64_t instruments, std::uint64_t count, std::uint64_t seed, std::uint64_t threads, const source::Profile &profile = {}) {
+	if (threads == 0 || threads > instruments) {
+		throw std::invalid_argument("each thread shall generate at least one instrument");
+	}
+	workload::Header header = workload::header({seed, book_size, instruments}, workload::slot(), threads);
+	header.count = count;
+	header.size = count * workload::slot();
+	int fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		throw std::runtime_error(std::strerror(errno));
+	}
+	std::size_t size = sizeof(header) + header.size;
+	if (::ftruncate(fd, size) < 0) {
+		::close(fd);
+		throw std::runtime_error(std::strerror(errno));
+	}
+	void *addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (addr == MAP_FAILED) {
+		throw std::runtime_error(std::strerror(errno));
+	}
+	char *requests = static_cast<char *>(addr) + sizeof(header);
+
+	std::vector<std::thread> workers;
+	std::vector<std::exception_ptr> errors(threads);
+	for (std::uint64_t k = 0; k < threads; ++k) {
+		workers.emplace_back([=, &errors] {
+			try {
+				std::uint64_t shard_instruments = (instruments - k + threads - 1) / threads;
+				std::uint64_t shard_count = Shard::size(count, k, threads);
+				Shard shard(requests, k, threads);
+				source::Generator<Shard> generator(shard, book_size * shard_instruments / instruments, shard_instruments, {
+					source::derive_seed(seed, k),
+					k * count,
+					static_cast<Order::InstrumentIdType>(k),
+					static_cast<Order::InstrumentIdType>(threads),
+				}, profile);
+				while (shard.size() < shard_count) {
+					generator.yield();
+				}
+			} catch (...) {
+				errors[k] = std::current_exception();
+			}
+		});
+	}
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+	// the header goes last, so that an interrupted generation leaves no valid workload
+	if (std::none_of(errors.begin(), errors.end(), [](const std::exception_ptr &error) { return error != nullptr; })) {
+		std::memcpy(addr, &header, sizeof(header));
+	}
+	::munmap(addr, size);
+	for (std::exception_ptr &error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+}
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef PIEX_HEADER_BENCHMARK_HISTOGRAM
+#define PIEX_HEADER_BENCHMARK_HISTOGRAM
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace piex {
+namespace benchmark {
+
+/// \remarks Log-linear histogram in the style of HdrHistogram. Values are bucketed by powers of two, and each bucket is split linearly into enough sub-buckets to keep `digits` significant decimal digits, so that the relative error of any recorded value is below 10^-digits whatever its magnitude.
+/// \remarks Values up to `highest` are tracked, larger ones are counted in the last bucket. Minimum, maximum, sum and count are kept exactly. Histograms of the same shape can be merged, so that threads may record into their own.
+class Histogram {
+public:
+	/// \param digits The number of significant decimal digits, from 1 to 5
+	/// \param highest The highest value to track, at least 2
+	explicit Histogram(int digits = 3, std::uint64_t highest = std::uint64_t(1) << 42) : digits_(digits), highest_(highest) {
+		if (digits < 1 || digits > 5 || highest < 2) {
+			throw std::invalid_argument("invalid histogram shape");
+		}
+		// sub-buckets of a bucket resolve 2 * 10^digits values, rounded up to a power of two
+		std::uint64_t resolution = 2;
+		for (int i = 0; i < digits; ++i) {
+			resolution *= 10;
+		}
+		sub_bucket_half_magnitude_ = 0;
+		while ((std::uint64_t(2) << sub_bucket_half_magnitude_) < resolution) {
+			++sub_bucket_half_magnitude_;
+		}
+		sub_bucket_half_count_ = std::uint64_t(1) << sub_bucket_half_magnitude_;
+		sub_bucket_mask_ = 2 * sub_bucket_half_count_ - 1;
+		// bucket 0 covers [0, 2 * half count), each following bucket doubles the range with half as many sub-buckets
+		int buckets = 1;
+		for (std::uint64_t limit = 2 * sub_bucket_half_count_; limit <= highest && limit <= std::numeric_limits<std::uint64_t>::max() / 2; limit <<= 1) {
+			++buckets;
+		}
+		counts_.assign((buckets + 1) * sub_bucket_half_count_, 0);
+	}
+
+	/// \effects Record `count` occurrences of `value`
+	void record(std::uint64_t value, std::uint64_t count = 1) {
+		std::size_t index = std::min(index_of(value), counts_.size() - 1);
+		counts_[index] += count;
+		total_ += count;
+		min_ = std::min(min_, value);
+		max_ = std::max(max_, value);
+		sum_ += static_cast<double>(value) * count;
+		sum2_ += static_cast<double>(value) * value * count;
+	}
+
+	/// \effects Add all values recorded by `other`
+	/// \requires `other` shall have the same shape
+	Histogram &merge(const Histogram &other) {
+		if (other.digits_ != digits_ || other.highest_ != highest_) {
+			throw std::invalid_argument("merging histograms of different shapes");
+		}
+		for (std::size_t i = 0; i < counts_.size(); ++i) {
+			counts_[i] += other.counts_[i];
+		}
+		total_ += other.total_;
+		min_ = std::min(min_, other.min_);
+		max_ = std::max(max_, other.max_);
+		sum_ += other.sum_;
+		sum2_ += other.sum2_;
+		return *this;
+	}
+
+	std::uint64_t count() const {
+		return total_;
+	}
+	/// \returns The smallest recorded value, 0 if empty
+	std::uint64_t min() const {
+		return total_ ? min_ : 0;
+	}
+	std::uint64_t max() const {
+		return max_;
+	}
+	double mean() const {
+		return total_ ? sum_ / total_ : 0;
+	}
+	double stddev() const {
+		if (!total_) {
+			return 0;
+		}
+		double mean = this->mean();
+		return std::sqrt(std::max(sum2_ / total_ - mean * mean, 0.0));
+	}
+
+	/// \returns The value below or at which `percentile` percent of recorded values fall, within the precision of the histogram and never above `max()`
+	/// \param percentile From 0 to 100
+	std::uint64_t value_at_percentile(double percentile) const {
+		if (!total_) {
+			return 0;
+		}
+		std::uint64_t target = static_cast<std::uint64_t>(std::ceil(std::min(percentile, 100.0) / 100 * total_));
+		target = std::max<std::uint64_t>(target, 1);
+		std::uint64_t seen = 0;
+		for (std::size_t i = 0; i < counts_.size(); ++i) {
+			seen += counts_[i];
+			if (seen >= target) {
+				return std::max(std::min(highest_in(i), max_), min_);
+			}
+		}
+		return max_;
+	}
+
+	int digits() const {
+		return digits_;
+	}
+private:
+	int digits_;
+	std::uint64_t highest_;
+	int sub_bucket_half_magnitude_;
+	std::uint64_t sub_bucket_half_count_;
+	std::uint64_t sub_bucket_mask_;
+	std::vector<std::uint64_t> counts_;
+	std::uint64_t total_ = 0;
+	std::uint64_t min_ = std::numeric_limits<std::uint64_t>::max();
+	std::uint64_t max_ = 0;
+	double sum_ = 0;
+	double sum2_ = 0;
+
+	std::size_t index_of(std::uint64_t value) const {
+		// position of the highest bit beyond the first bucket
+		int bucket = 63 - __builtin_clzll(value | sub_bucket_mask_) - sub_bucket_half_magnitude_;
+		std::uint64_t sub_bucket = value >> bucket;
+		return (static_cast<std::size_t>(bucket) << sub_bucket_half_magnitude_) + sub_bucket;
+	}
+
+	/// \returns The highest value counted at `index`
+	std::uint64_t highest_in(std::size_t index) const {
+		// sub-buckets below half count only exist in bucket 0
+		std::int64_t bucket = static_cast<std::int64_t>(index >> sub_bucket_half_magnitude_) - 1;
+		std::uint64_t sub_bucket = (index & (sub_bucket_half_count_ - 1)) + sub_bucket_half_count_;
+		if (bucket < 0) {
+			sub_bucket -= sub_bucket_half_count_;
+			bucket = 0;
+		}
+		std::uint64_t lowest = sub_bucket << bucket;
+		return lowest + (std::uint64_t(1) << bucket) - 1;
+	}
+};
+
+}
+}
+
+#endif
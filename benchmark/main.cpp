@@ -1,9 +1,19 @@
+#include <unistd.h>
 #include <cstdint>
 #include <cstring>
 #include <cstdlib>
+#include <cmath>
 #include <string>
 #include <memory>
+#include <vector>
+#include <utility>
+#include <thread>
+#include <exception>
+#include <stdexcept>
+#include <chrono>
 #include <iostream>
+#include <iomanip>
+#include <limits>
 #include "benchmark/source/source.h"
 #include "benchmark/source/generator.h"
 #include "benchmark/source/file.h"
@@ -12,58 +22,207 @@
 #include "benchmark/destination/server.h"
 #include "benchmark/destination/file.h"
 #include "benchmark/benchmark.h"
+#include "benchmark/generate.h"
 
 using namespace piex::benchmark;
 
 void error(const char *prog) {
 	std::cerr
-		<< "Usage: " << prog << "source destination book_size num_of_requests" << std::endl
+		<< "Usage: " << prog << " [options] source destination book_size num_of_requests [instruments]" << std::endl
 		<< std::endl
-		<< "    source           \"generator\" or file path" << std::endl
-		<< "    destination      \"exchange\", host:port or file path" << std::endl
+		<< "    source           \"generator\" or workload file path" << std::endl
+		<< "    destination      \"exchange\", host:port or workload file path" << std::endl
 		<< "    book_size        an integer" << std::endl
-		<< "    num_of_requests  an integer" << std::endl;
+		<< "    num_of_requests  an integer" << std::endl
+		<< "    instruments      an integer, number of instruments to generate requests for (default: 1)" << std::endl
+		<< std::endl
+		<< "Options:" << std::endl
+		<< "    -r rate          requests per second to submit open-loop, 0 for closed-loop (default: 0)" << std::endl
+		<< "    -a arrival       \"constant\", \"poisson\" or \"bursty\" gaps between open-loop requests (default: constant)" << std::endl
+		<< "    -c connections   number of connections to the destination, each fed by its own generator; against a server, only with the epoll server (default: 1)" << std::endl
+		<< "    -t threads       number of threads to spread the connections over, or to generate a workload file with (default: 1)" << std::endl
+		<< "    -s seed          seed of generated requests (default: 0)" << std::endl
+		<< "    -p profile       mix of generated requests: \"default\", \"hft\", \"bursty\", \"deep\", \"wide\" or \"sweep\" (default: default)" << std::endl;
 	std::exit(1);
 }
 
-int main(int argc, const char *argv[]) {
-	if (argc != 5) {
-		error(argv[0]);
+std::uint64_t parse(const char *prog, const char *arg) {
+	char *end;
+	std::uint64_t value = strtoull(arg, &end, 0);
+	if (*arg == '\0' || *end != '\0') {
+		error(prog);
 	}
+	return value;
+}
 
-	char *end;
-	std::uint64_t book_size = strtoull(argv[3], &end, 0);
-	if (*end != '\0') {
-		error(argv[0]);
+int main(int argc, char *argv[]) {
+	double rate = 0;
+	Schedule::Arrival arrival = Schedule::CONSTANT;
+	std::uint64_t connections = 1;
+	std::uint64_t threads = 1;
+	std::uint64_t seed = 0;
+	source::Profile profile;
+	for (int opt; (opt = ::getopt(argc, argv, "r:a:c:t:s:p:")) != -1;) {
+		char *end;
+		switch (opt) {
+		case 'r':
+			rate = strtod(optarg, &end);
+			if (*end != '\0' || !(rate >= 0) || std::isinf(rate)) {
+				error(argv[0]);
+			}
+			break;
+		case 'a':
+			if (std::strcmp(optarg, "poisson") == 0) {
+				arrival = Schedule::POISSON;
+			} else if (std::strcmp(optarg, "bursty") == 0) {
+				arrival = Schedule::BURSTY;
+			} else if (std::strcmp(optarg, "constant") != 0) {
+				error(argv[0]);
+			}
+			break;
+		case 'c':
+			connections = parse(argv[0], optarg);
+			break;
+		case 't':
+			threads = parse(argv[0], optarg);
+			break;
+		case 's':
+			seed = parse(argv[0], optarg);
+			break;
+		case 'p':
+			try {
+				profile = source::profile(optarg);
+			} catch (const std::invalid_argument &) {
+				error(argv[0]);
+			}
+			break;
+		default:
+			error(argv[0]);
+		}
 	}
-	std::uint64_t num_of_requests = strtoull(argv[4], &end, 0);
-	if (*end != '\0') {
+	argc -= optind - 1;
+	argv += optind - 1;
+	if (argc != 5 && argc != 6) {
 		error(argv[0]);
 	}
 
-	Benchmark benchmark;
-	std::unique_ptr<source::Source<Benchmark>> source;
-	std::unique_ptr<destination::Destination<Benchmark>> destination;
+	std::uint64_t book_size = parse(argv[0], argv[3]);
+	std::uint64_t num_of_requests = parse(argv[0], argv[4]);
+	std::uint64_t instruments = argc > 5 ? parse(argv[0], argv[5]) : 1;
+	if (instruments == 0 || instruments > std::numeric_limits<piex::Order::InstrumentIdType>::max() || connections == 0 || threads == 0) {
+		error(argv[0]);
+	}
+	bool generator = std::strcmp(argv[1], "generator") == 0;
+	bool exchange = std::strcmp(argv[2], "exchange") == 0;
+	const char *pos = std::strchr(argv[2], ':');
 
-	if (std::strcmp(argv[1], "generator") == 0) {
-		source = std::make_unique<source::Generator<Benchmark>>(benchmark, book_size);
-	} else {
-		source = std::make_unique<source::File<Benchmark>>(benchmark, argv[1]);
+	if (generator && !exchange && pos == nullptr) {
+		// a workload file: shards of instruments generated in parallel
+		if (connections > 1 || threads > instruments) {
+			std::cerr << "workload files are generated by one connection, with at most one thread per instrument" << std::endl;
+			return 1;
+		}
+		auto start = std::chrono::steady_clock::now();
+		generate::generate(argv[2], book_size, instruments, num_of_requests, seed, threads, profile);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout
+			<< "Generated " << num_of_requests << " requests in " << seconds << " s" << std::endl
+			<< "    Average: " << std::fixed << std::setprecision(2) << num_of_requests / seconds << " req/s" << std::endl;
+		return 0;
+	}
+	if (threads > connections) {
+		error(argv[0]);
 	}
+	if (connections > 1 && (!generator || (!exchange && pos == nullptr))) {
+		// order ids must not collide and files cannot be shared
+		std::cerr << "multiple connections require the generator source and an exchange or server destination" << std::endl;
+		return 1;
+	}
+#if PIEX_OPTION_SERVER != PIEX_OPTION_SERVER_EPOLL
+	if (connections > 1 && pos != nullptr) {
+		// other servers serve one client at a time: further connections would wait forever
+		std::cerr << "multiple connections to a server require a build configured with the epoll server" << std::endl;
+		return 1;
+	}
+#endif
 
-	if (std::strcmp(argv[2], "exchange") == 0) {
-		destination = std::make_unique<destination::Exchange<Benchmark>>(benchmark);
-	} else {
-		const char *pos = std::strchr(argv[2], ':');
-		if (pos != nullptr) {
+	std::vector<std::unique_ptr<Benchmark>> benchmarks;
+	std::vector<std::unique_ptr<source::Source<Benchmark>>> sources;
+	std::vector<std::unique_ptr<destination::Destination<Benchmark>>> destinations;
+	for (std::uint64_t i = 0; i < connections; ++i) {
+		Benchmark &benchmark = *benchmarks.emplace_back(std::make_unique<Benchmark>());
+		if (generator) {
+			// a stream and an id range of its own for each connection
+			sources.push_back(std::make_unique<source::Generator<Benchmark>>(benchmark, book_size / connections, instruments, source::Partition{
+				source::derive_seed(seed, i),
+				i * num_of_requests,
+			}, profile));
+		} else {
+			auto file = std::make_unique<source::File<Benchmark>>(benchmark, argv[1]);
+			if (num_of_requests > file->header().count) {
+				std::cerr << "the workload holds " << file->header().count << " requests only" << std::endl;
+				return 1;
+			}
+			sources.push_back(std::move(file));
+		}
+		if (exchange) {
+			destinations.push_back(std::make_unique<destination::Exchange<Benchmark>>(benchmark));
+		} else if (pos != nullptr) {
 			std::string host(argv[2], pos - argv[2]);
 			std::string port(pos + 1);
-			destination = std::make_unique<destination::Server<Benchmark>>(benchmark, host.c_str(), port.c_str());
+			destinations.push_back(std::make_unique<destination::Server<Benchmark>>(benchmark, host.c_str(), port.c_str()));
 		} else {
-			destination = std::make_unique<destination::File<Benchmark>>(benchmark, argv[2]);
+			destinations.push_back(std::make_unique<destination::File<Benchmark>>(benchmark, argv[2], workload::Parameters{seed, book_size, instruments}));
 		}
+		benchmark.bind(sources.back().get(), destinations.back().get());
 	}
 
-	benchmark.start(source.get(), destination.get(), num_of_requests);
-	std::cout << benchmark.stats() << std::endl;
+	// connection i goes to thread i % threads, which submits its share of requests and of the rate
+	std::vector<std::thread> workers;
+	std::vector<std::exception_ptr> errors(threads);
+	for (std::uint64_t t = 0; t < threads; ++t) {
+		workers.emplace_back([&, t] {
+			try {
+				std::vector<Benchmark *> group;
+				for (std::uint64_t i = t; i < connections; i += threads) {
+					group.push_back(benchmarks[i].get());
+				}
+				std::uint64_t requests = num_of_requests / threads + (t < num_of_requests % threads);
+				if (rate == 0) {
+					Benchmark::run(group, requests);
+				} else {
+					Schedule schedule(rate / threads, arrival, source::derive_seed(seed, t));
+					Benchmark::run(group, requests, &schedule);
+				}
+			} catch (...) {
+				errors[t] = std::current_exception();
+			}
+		});
+	}
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+	for (std::exception_ptr &error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+
+	Stats stats = benchmarks[0]->stats();
+	Stats uncorrected_stats = benchmarks[0]->uncorrected_stats();
+	for (std::uint64_t i = 1; i < connections; ++i) {
+		stats.merge(benchmarks[i]->stats());
+		uncorrected_stats.merge(benchmarks[i]->uncorrected_stats());
+	}
+	if (rate == 0) {
+		std::cout << stats << std::endl;
+	} else {
+		std::cout
+			<< "Corrected (from intended send times)" << std::endl
+			<< std::endl
+			<< stats << std::endl
+			<< "Uncorrected (from actual send times)" << std::endl
+			<< std::endl
+			<< uncorrected_stats << std::endl;
+	}
 }
@@ -0,0 +1,41 @@
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <iostream>
+#include <algorithm>
+#include "benchmark/micro/micro.h"
+
+int main(int argc, const char *argv[]) {
+	const char *suite = argc > 1 ? argv[1] : "all";
+	bool known = std::strcmp(suite, "all") == 0 || std::any_of(micro::registry().begin(), micro::registry().end(), [&](const micro::Benchmark &benchmark) {
+		return std::strcmp(benchmark.suite, suite) == 0;
+	});
+	if (!known || argc == 3 || argc > 5) {
+		std::cerr
+			<< "Usage: " << argv[0] << " [suite [cpu_a cpu_b [count]]]" << std::endl
+			<< std::endl
+			<< "    suite         all (default), spsc, nsemaphore or socket" << std::endl
+			<< "    cpu_a, cpu_b  cpus to pin the two threads to (default: 0 1)" << std::endl
+			<< "    count         number of operations streamed (default: 10000000)" << std::endl;
+		return 1;
+	}
+	micro::Options options = {
+		argc > 2 ? std::atoi(argv[2]) : 0,
+		argc > 3 ? std::atoi(argv[3]) : 1,
+		argc > 4 ? std::strtoull(argv[4], nullptr, 0) : 10000000,
+	};
+	if (options.cpu_a >= 0 && options.cpu_b >= 0 && std::thread::hardware_concurrency() <= static_cast<unsigned>(std::max(options.cpu_a, options.cpu_b))) {
+		std::cerr << "not enough cpus, pass -1 -1 to leave the placement to the scheduler" << std::endl;
+		return 1;
+	}
+	// registration order depends on the link order
+	std::stable_sort(micro::registry().begin(), micro::registry().end(), [](const micro::Benchmark &a, const micro::Benchmark &b) {
+		return std::strcmp(a.suite, b.suite) < 0;
+	});
+	micro::print_header();
+	for (const micro::Benchmark &benchmark : micro::registry()) {
+		if (std::strcmp(suite, "all") == 0 || std::strcmp(suite, benchmark.suite) == 0) {
+			benchmark.run(benchmark.name, options);
+		}
+	}
+}
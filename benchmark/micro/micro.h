@@ -0,0 +1,87 @@
+#ifndef PIEX_HEADER_BENCHMARK_MICRO
+#define PIEX_HEADER_BENCHMARK_MICRO
+
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+
+/// \remarks Microbenchmarks of the building blocks the socket backends and servers are made of. Every benchmark registers itself from its own translation unit, so that implementations selected by the same option, which share names, can be linked into one binary: such a unit configures itself with a template instead of `config/config.h` and renames the `piex` namespace.
+namespace micro {
+
+struct Options {
+	// cpus to pin the two threads of a benchmark to, negative to leave the placement to the scheduler
+	int cpu_a;
+	int cpu_b;
+	// number of operations of streaming benchmarks, ping-pong benchmarks run fewer
+	std::uint64_t count;
+};
+
+struct Benchmark {
+	const char *suite;
+	const char *name;
+	void (*run)(const char *name, const Options &options);
+};
+
+inline std::vector<Benchmark> &registry() {
+	static std::vector<Benchmark> benchmarks;
+	return benchmarks;
+}
+
+/// \remarks Adds a benchmark to `registry` during static initialization
+struct Registration {
+	Registration(const char *suite, const char *name, void (*run)(const char *, const Options &)) {
+		registry().push_back({suite, name, run});
+	}
+};
+
+inline std::uint64_t now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline void print_header() {
+	std::cout
+		<< std::left
+		<< std::setw(12) << "suite"
+		<< std::setw(28) << "name"
+		<< std::setw(12) << "pattern"
+		<< std::right
+		<< std::setw(8) << "bytes"
+		<< std::setw(12) << "ns/op"
+		<< std::setw(10) << "p50"
+		<< std::setw(10) << "p90"
+		<< std::setw(10) << "p99"
+		<< std::setw(10) << "p99.9"
+		<< std::setw(10) << "max"
+		<< std::endl;
+}
+
+/// \effects Print a line of results
+/// \param samples Nanoseconds taken by each operation. May be empty if only the total is known
+/// \param total Nanoseconds taken by all `operations`
+inline void print(const char *suite, const char *name, const char *pattern, std::size_t bytes, std::vector<std::uint64_t> &samples, std::uint64_t total, std::uint64_t operations) {
+	std::cout
+		<< std::left
+		<< std::setw(12) << suite
+		<< std::setw(28) << name
+		<< std::setw(12) << pattern
+		<< std::right
+		<< std::setw(8) << bytes
+		<< std::setw(12) << std::fixed << std::setprecision(1) << static_cast<double>(total) / operations;
+	if (!samples.empty()) {
+		std::sort(samples.begin(), samples.end());
+		for (double percentile : {50.0, 90.0, 99.0, 99.9}) {
+			std::cout << std::setw(10) << samples[static_cast<std::size_t>(percentile / 100 * (samples.size() - 1))];
+		}
+		std::cout << std::setw(10) << samples.back();
+	}
+	std::cout << std::endl;
+}
+
+}
+
+#endif
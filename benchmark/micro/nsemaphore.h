@@ -0,0 +1,75 @@
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "benchmark/micro/micro.h"
+#include "src/nsemaphore/nsemaphore.h"
+#include "src/utility/thread.h"
+
+namespace micro {
+/// \remarks Included by one translation unit per nsemaphore implementation, after it selected the implementation and renamed `piex`. Unnamed, so that each unit has its own copy
+namespace {
+namespace nsemaphore {
+
+using piex::nsemaphore::Strict;
+
+/// \effects Bounce a token between two threads through two nsemaphores and print the round trips, each made of two post-to-wake handoffs
+void ping_pong(const char *name, const Options &options) {
+	std::uint64_t rounds = options.count / 64;
+	Strict ping(0), pong(0);
+	std::thread echo([&] {
+		for (std::uint64_t i = 0; i < rounds; ++i) {
+			ping.wait(1);
+			ping.consume(1);
+			pong.post(1);
+		}
+	});
+	piex::utility::thread::pin(echo.native_handle(), options.cpu_b);
+	piex::utility::thread::pin(pthread_self(), options.cpu_a);
+	std::vector<std::uint64_t> samples(rounds);
+	std::uint64_t start = now();
+	for (std::uint64_t i = 0; i < rounds; ++i) {
+		std::uint64_t begin = now();
+		ping.post(1);
+		pong.wait(1);
+		pong.consume(1);
+		samples[i] = now() - begin;
+	}
+	std::uint64_t end = now();
+	echo.join();
+	print("nsemaphore", name, "ping-pong", 0, samples, end - start, rounds);
+}
+
+/// \effects Stream tokens from one thread to another through a window of `SLOTS` tokens, as the socket daemons do with bytes, and print the time per token
+void stream(const char *name, const Options &options) {
+	constexpr std::size_t SLOTS = 1024;
+	std::uint64_t count = options.count / 4;
+	Strict data(0), space(SLOTS);
+	std::thread consumer([&] {
+		for (std::uint64_t i = 0; i < count; ++i) {
+			data.wait(1);
+			data.consume(1);
+			space.post(1);
+		}
+	});
+	piex::utility::thread::pin(consumer.native_handle(), options.cpu_b);
+	piex::utility::thread::pin(pthread_self(), options.cpu_a);
+	std::uint64_t start = now();
+	for (std::uint64_t i = 0; i < count; ++i) {
+		space.wait(1);
+		space.consume(1);
+		data.post(1);
+	}
+	consumer.join();
+	std::uint64_t end = now();
+	std::vector<std::uint64_t> samples;
+	print("nsemaphore", name, "stream", 0, samples, end - start, count);
+}
+
+void run(const char *name, const Options &options) {
+	ping_pong(name, options);
+	stream(name, options);
+}
+
+}
+}
+}
@@ -0,0 +1,7 @@
+// configured on its own, whatever config/config.h selects
+#define PIEX_HEADER_CONFIG_CONFIG
+#include "config/templates/multithreaded_atomic_flush.h"
+#define piex piex_nsemaphore_condition_variable
+#include "benchmark/micro/nsemaphore.h"
+
+static micro::Registration registration("nsemaphore", "condition_variable", &micro::nsemaphore::run);
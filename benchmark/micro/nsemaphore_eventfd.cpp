@@ -0,0 +1,7 @@
+// configured on its own, whatever config/config.h selects
+#define PIEX_HEADER_CONFIG_CONFIG
+#include "config/templates/eventfd.h"
+#define piex piex_nsemaphore_eventfd
+#include "benchmark/micro/nsemaphore.h"
+
+static micro::Registration registration("nsemaphore", "eventfd", &micro::nsemaphore::run);
@@ -0,0 +1,60 @@
+#include <cstdint>
+#include <thread>
+#include <memory>
+#include <vector>
+#include "benchmark/micro/micro.h"
+#include "src/socket/socket.h"
+#include "src/utility/thread.h"
+
+namespace micro {
+/// \remarks Included by one translation unit per socket backend, after it selected the backend and renamed `piex`. Unnamed, so that each unit has its own copy
+namespace {
+namespace socket {
+
+using piex::Socket;
+
+// packet sizes of compact and trivial requests, of a burst of them, and of a large batch
+constexpr std::size_t SIZES[] = {16, 64, 256, 1024};
+
+/// \effects Echo packets of a connected pair of sockets between two threads, one packet size after another, and print the round trips
+/// \param port A port on 127.0.0.1 not used by other benchmarks
+void run(const char *name, const char *port, const Options &options) {
+	std::uint64_t rounds = options.count / 1000;
+	Socket listener, client;
+	listener.listen("127.0.0.1", port);
+	client.connect("127.0.0.1", port);
+	Socket server = listener.accept();
+	std::thread echo([&] {
+		char buffer[SIZES[std::size(SIZES) - 1]];
+		for (std::size_t size : SIZES) {
+			for (std::uint64_t i = 0; i < rounds; ++i) {
+				if (server.read(buffer, size) != static_cast<int>(size)) {
+					return;
+				}
+				server.write(buffer, size);
+				server.flush();
+			}
+		}
+	});
+	piex::utility::thread::pin(echo.native_handle(), options.cpu_b);
+	piex::utility::thread::pin(pthread_self(), options.cpu_a);
+	char buffer[SIZES[std::size(SIZES) - 1]] = {};
+	std::vector<std::uint64_t> samples(rounds);
+	for (std::size_t size : SIZES) {
+		std::uint64_t start = now();
+		for (std::uint64_t i = 0; i < rounds; ++i) {
+			std::uint64_t begin = now();
+			client.write(buffer, size);
+			client.flush();
+			client.read(buffer, size);
+			samples[i] = now() - begin;
+		}
+		std::uint64_t end = now();
+		print("socket", name, "round trip", size, samples, end - start, rounds);
+	}
+	echo.join();
+}
+
+}
+}
+}
@@ -0,0 +1,11 @@
+// configured on its own, whatever config/config.h selects
+#define PIEX_HEADER_CONFIG_CONFIG
+#include "config/templates/buffered.h"
+#define piex piex_socket_buffered
+#include "benchmark/micro/socket.h"
+
+static void run(const char *name, const micro::Options &options) {
+	micro::socket::run(name, "3401", options);
+}
+
+static micro::Registration registration("socket", "buffered", &run);
@@ -0,0 +1,11 @@
+// configured on its own, whatever config/config.h selects
+#define PIEX_HEADER_CONFIG_CONFIG
+#include "config/templates/io_uring.h"
+#define piex piex_socket_io_uring
+#include "benchmark/micro/socket.h"
+
+static void run(const char *name, const micro::Options &options) {
+	micro::socket::run(name, "3405", options);
+}
+
+static micro::Registration registration("socket", "io_uring", &run);
@@ -0,0 +1,11 @@
+// configured on its own, whatever config/config.h selects
+#define PIEX_HEADER_CONFIG_CONFIG
+#include "config/templates/multithreaded_atomic_flush.h"
+#define piex piex_socket_multithreaded_atomic_flush
+#include "benchmark/micro/socket.h"
+
+static void run(const char *name, const micro::Options &options) {
+	micro::socket::run(name, "3404", options);
+}
+
+static micro::Registration registration("socket", "multithreaded_atomic_flush", &run);
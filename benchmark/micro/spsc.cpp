@@ -0,0 +1,116 @@
+#include <cstdint>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "benchmark/micro/micro.h"
+#include "src/utility/spsc.h"
+#include "src/utility/cpu.h"
+#include "src/utility/thread.h"
+
+using namespace piex::utility;
+
+/// \remarks The layout the socket daemons used before `spsc::Ring`: both positions share a cache line with each other and with the slots, and every check loads the remote position
+template <class T, std::size_t N>
+class PackedRing {
+public:
+	T *reserve() {
+		std::size_t tail = tail_.load(std::memory_order_relaxed);
+		return tail - head_.load(std::memory_order_acquire) == N ? nullptr : &buf_[tail & (N - 1)];
+	}
+	void publish() {
+		tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+	T *front() {
+		std::size_t head = head_.load(std::memory_order_relaxed);
+		return head == tail_.load(std::memory_order_acquire) ? nullptr : &buf_[head & (N - 1)];
+	}
+	void pop() {
+		head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+private:
+	std::atomic_size_t head_ = 0;
+	std::atomic_size_t tail_ = 0;
+	T buf_[N];
+};
+
+constexpr std::size_t SLOTS = 1024;
+
+template <class Ring>
+void push(Ring &ring, std::uint64_t value) {
+	cpu::Backoff<> backoff;
+	std::uint64_t *slot;
+	while (!(slot = ring.reserve())) {
+		backoff();
+	}
+	*slot = value;
+	ring.publish();
+}
+
+template <class Ring>
+std::uint64_t pop(Ring &ring) {
+	cpu::Backoff<> backoff;
+	std::uint64_t *slot;
+	while (!(slot = ring.front())) {
+		backoff();
+	}
+	std::uint64_t value = *slot;
+	ring.pop();
+	return value;
+}
+
+/// \effects Bounce a value between two threads through two rings and print the round trips
+template <class Ring>
+void ping_pong(const char *name, const micro::Options &options) {
+	std::uint64_t rounds = options.count / 16;
+	auto ping = std::make_unique<Ring>();
+	auto pong = std::make_unique<Ring>();
+	std::thread echo([&] {
+		for (std::uint64_t i = 0; i < rounds; ++i) {
+			push(*pong, pop(*ping));
+		}
+	});
+	thread::pin(echo.native_handle(), options.cpu_b);
+	thread::pin(pthread_self(), options.cpu_a);
+	std::vector<std::uint64_t> samples(rounds);
+	std::uint64_t start = micro::now();
+	for (std::uint64_t i = 0; i < rounds; ++i) {
+		std::uint64_t begin = micro::now();
+		push(*ping, i);
+		pop(*pong);
+		samples[i] = micro::now() - begin;
+	}
+	std::uint64_t end = micro::now();
+	echo.join();
+	micro::print("spsc", name, "ping-pong", sizeof(std::uint64_t), samples, end - start, rounds);
+}
+
+/// \effects Stream values from one thread to another and print the time per value
+template <class Ring>
+void stream(const char *name, const micro::Options &options) {
+	auto ring = std::make_unique<Ring>();
+	std::thread consumer([&] {
+		for (std::uint64_t i = 0; i < options.count; ++i) {
+			pop(*ring);
+		}
+	});
+	thread::pin(consumer.native_handle(), options.cpu_b);
+	thread::pin(pthread_self(), options.cpu_a);
+	std::uint64_t start = micro::now();
+	for (std::uint64_t i = 0; i < options.count; ++i) {
+		push(*ring, i);
+	}
+	consumer.join();
+	std::uint64_t end = micro::now();
+	std::vector<std::uint64_t> samples;
+	micro::print("spsc", name, "stream", sizeof(std::uint64_t), samples, end - start, options.count);
+}
+
+template <class Ring>
+void run(const char *name, const micro::Options &options) {
+	ping_pong<Ring>(name, options);
+	stream<Ring>(name, options);
+}
+
+static micro::Registration packed("spsc", "packed", &run<PackedRing<std::uint64_t, SLOTS>>);
+static micro::Registration padded("spsc", "padded", &run<spsc::Ring<std::uint64_t, SLOTS>>);
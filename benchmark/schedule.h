@@ -0,0 +1,73 @@
+#ifndef PIEX_HEADER_BENCHMARK_SCHEDULE
+#define PIEX_HEADER_BENCHMARK_SCHEDULE
+
+#include <cstdint>
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+
+namespace piex {
+namespace benchmark {
+
+/// \remarks Intended send times of an open-loop benchmark, fixed in advance by the target rate regardless of how fast the destination responds
+class Schedule {
+public:
+	enum Arrival {
+		// evenly spaced requests
+		CONSTANT,
+		// exponentially distributed gaps, i.e. independent arrivals
+		POISSON,
+		// Poisson arrivals alternating between bursts at `BURST` times the rate and lulls slow enough to keep the mean rate, each of `PHASE` requests on average
+		BURSTY,
+	};
+
+	constexpr static double BURST = 5;
+	constexpr static std::uint64_t PHASE = 1000;
+
+	/// \param rate Target rate in requests per second
+	/// \param seed Seed of Poisson gaps and of phases, so that runs are repeatable
+	Schedule(double rate, Arrival arrival = CONSTANT, std::uint64_t seed = 0) :
+		interval_(1e9 / validate(rate)),
+		arrival_(arrival),
+		gen_(seed),
+		gap_(rate / 1e9) {}
+
+	/// \returns Offset of the intended send time of the next request from the start of the run
+	std::chrono::nanoseconds next() {
+		double offset = arrival_ == CONSTANT ? interval_ * count_ : elapsed_;
+		++count_;
+		if (arrival_ == POISSON) {
+			elapsed_ += gap_(gen_);
+		} else if (arrival_ == BURSTY) {
+			// bursts and lulls hold as many requests on average, so gaps are scaled by 1 / BURST and 2 - 1 / BURST
+			elapsed_ += gap_(gen_) * (burst_ ? 1 / BURST : 2 - 1 / BURST);
+			if (switch_(gen_)) {
+				burst_ = !burst_;
+			}
+		}
+		return std::chrono::nanoseconds(static_cast<std::chrono::nanoseconds::rep>(offset));
+	}
+private:
+	const double interval_;
+	const Arrival arrival_;
+	std::mt19937_64 gen_;
+	std::exponential_distribution<double> gap_;
+	std::bernoulli_distribution switch_{1.0 / PHASE};
+	bool burst_ = true;
+	// constant offsets are computed from the count so that rounding errors do not accumulate
+	std::uint64_t count_ = 0;
+	double elapsed_ = 0;
+
+	static double validate(double rate) {
+		if (!(rate > 0) || std::isinf(rate)) {
+			throw std::invalid_argument("invalid request rate");
+		}
+		return rate;
+	}
+};
+
+}
+}
+
+#endif
@@ -2,47 +2,47 @@
 #define PIEX_HEADER_BENCHMARK_SOURCE_FILE
 
 #include <string>
-#include <fstream>
 #include <stdexcept>
 #include "src/packets/packets.h"
 #include "benchmark/source/source.h"
+#include "benchmark/workload.h"
 
 namespace piex {
 namespace benchmark {
 namespace source {
 
+/// \remarks Replays a workload file. The file is mapped and requests are handed to `Handler` where they lie in the mapping
 template <class Handler>
 class File : public Source<Handler> {
 public:
 	File(Handler &handler, const std::string path) :
 		handler_(handler),
-		file_(path, std::ios_base::in | std::ios_base::binary)
-	{
-		if (!file_.is_open()) {
-			throw std::invalid_argument("cannot open file \"" + path + "\"");
-		}
-	}
+		mapping_(path.c_str()),
+		cursor_(mapping_.begin()) {}
 	void yield() {
-		file_.read(data_, sizeof(Request::Header));
-		switch (request_.data().header.type()) {
+		if (cursor_ == mapping_.end()) {
+			throw std::out_of_range("workload exhausted");
+		}
+		const Request::Data &request = *reinterpret_cast<const Request::Data *>(cursor_);
+		switch (request.header.type()) {
 		case Request::PLACE:
-			file_.read(data_ + sizeof(Request::Header), sizeof(Request::Place) - sizeof(Request::Header));
-			handler_.process(request_.data().place);
+			handler_.process(request.place);
 			break;
 		case Request::CANCEL:
-			file_.read(data_ + sizeof(Request::Header), sizeof(Request::Cancel) - sizeof(Request::Header));
-			handler_.process(request_.data().cancel);
+			handler_.process(request.cancel);
 			break;
 		case Request::FLUSH:
 			break;
 		}
+		cursor_ += mapping_.stride(request.header.type());
+	}
+	const workload::Header &header() const {
+		return mapping_.header();
 	}
 private:
 	Handler &handler_;
-	char buf_[sizeof(Request)];
-	Request &request_ = *reinterpret_cast<Request *>(buf_);
-	char *data_ = reinterpret_cast<char *>(&request_.data());
-	std::fstream file_;
+	workload::Mapping mapping_;
+	const char *cursor_;
 };
 
 }
@@ -5,7 +5,10 @@
 #include <utility>
 #include <random>
 #include <set>
+#include <vector>
 #include <algorithm>
+#include <string>
+#include <stdexcept>
 #include "src/packets/packets.h"
 #include "src/order/order.h"
 #include "benchmark/source/source.h"
@@ -38,14 +41,84 @@ public:
 	}
 };
 
+/// \remarks The share of a workload a generator produces: its instruments are numbered from `first_instrument` by `instrument_stride`, and its ids from `first_id`. Generators of disjoint partitions may feed the same exchange.
+struct Partition {
+	std::uint64_t seed = 0;
+	Order::IdType first_id = 0;
+	Order::InstrumentIdType first_instrument = 0;
+	Order::InstrumentIdType instrument_stride = 1;
+};
+
+/// \remarks The mix of requests a generator produces. The defaults are the original mix: a quarter of marketable orders, the books kept around the expected size by cancelling orders deep in them, quantities uniform in [1, 100] and prices half-Poisson distributed around the top of the books.
+struct Profile {
+	// one in `match_odds` requests is a marketable order
+	unsigned match_odds = 4;
+	// the expected book size is multiplied by `depth`
+	double depth = 1;
+	// distances of prices from the top of the book are multiplied by `dispersion`
+	double dispersion = 1;
+	Order::QuantityType min_quantity = 1;
+	Order::QuantityType max_quantity = 100;
+	// marketable orders reach `sweep` times further through the opposite book, with `sweep` times the quantity
+	double sweep = 1;
+	// cancel orders close to the top of the book rather than deep in it
+	bool cancel_top = false;
+	// requests go to the same instrument for runs of `burst` requests on average
+	double burst = 1;
+};
+
+/// \returns The profile called `name`
+/// \remarks `default`; `hft`: cancel-heavy, small orders placed and cancelled close to the top, about 95% of orders are cancelled once the books are filled; `bursty`: runs of requests on one instrument; `deep`: ten times deeper books over more price levels, few trades; `wide`: prices twenty times more dispersed; `sweep`: marketable orders crossing many price levels
+inline Profile profile(const std::string &name) {
+	Profile profile;
+	if (name == "default") {
+	} else if (name == "hft") {
+		profile.match_odds = 100;
+		profile.dispersion = 0.05;
+		profile.max_quantity = 10;
+		profile.cancel_top = true;
+	} else if (name == "bursty") {
+		profile.burst = 256;
+	} else if (name == "deep") {
+		profile.match_odds = 20;
+		profile.depth = 10;
+		profile.dispersion = 4;
+	} else if (name == "wide") {
+		profile.dispersion = 20;
+	} else if (name == "sweep") {
+		profile.sweep = 20;
+	} else {
+		throw std::invalid_argument("unknown profile \"" + name + "\"");
+	}
+	return profile;
+}
+
+/// \returns A seed for stream `index` of a workload of `seed`, so that neighbouring streams are not correlated
+/// \remarks The finalizer of SplitMix64
+inline std::uint64_t derive_seed(std::uint64_t seed, std::uint64_t index) {
+	std::uint64_t z = seed + (index + 1) * 0x9e3779b97f4a7c15ULL;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
 template <class Handler>
 class Generator : public Source<Handler> {
 public:
-	Generator(Handler &handler, std::uint64_t book_size) : handler_(handler), book_size_(book_size), gen_(0) {}
+	// book_size is the expected total size of the books of all instruments of the partition
+	Generator(Handler &handler, std::uint64_t book_size, Order::InstrumentIdType instruments = 1, const Partition &partition = {}, const Profile &profile = {}) :
+		handler_(handler),
+		book_size_(std::max<std::uint64_t>(static_cast<std::uint64_t>(book_size * profile.depth) / instruments, 1)),
+		gen_(partition.seed),
+		books_(instruments),
+		partition_(partition),
+		profile_(profile),
+		id_(partition.first_id) {}
 
 	// generate random requests
 	void yield() {
 		update_trend();
+		update_instrument();
 		bool buysell = random_buysell();
 		if (random_action_match()) {
 			// place match
@@ -63,8 +136,12 @@ private:
 	Handler &handler_;
 	const std::uint64_t book_size_;
 	std::mt19937_64 gen_;
-	std::pair<Orders<BuyOrder>, Orders<SellOrder>> orders_;
-	Order::IdType id_ = 0;
+	std::vector<std::pair<Orders<BuyOrder>, Orders<SellOrder>>> books_;
+	const Partition partition_;
+	const Profile profile_;
+	// index of the current instrument in the partition
+	Order::InstrumentIdType instrument_ = 0;
+	Order::IdType id_;
 	// true for rising, false for falling
 	bool trend_ = true;
 
@@ -77,9 +154,33 @@ private:
 		return std::max(a, b + MIN_PRICE) - b;
 	}
 
+	// order books of the current instrument
+	std::pair<Orders<BuyOrder>, Orders<SellOrder>> &orders() {
+		return books_[instrument_];
+	}
+
+	Order::InstrumentIdType instrument() const {
+		return partition_.first_instrument + instrument_ * partition_.instrument_stride;
+	}
+
+	// pick the instrument of the next request
+	// probability: uniform among all instruments, kept for the next request with probability 1 - 1 / burst
+	void update_instrument() {
+		if (profile_.burst > 1) {
+			std::bernoulli_distribution keep(1 - 1 / profile_.burst);
+			if (keep(gen_)) {
+				return;
+			}
+		}
+		if (books_.size() > 1) {
+			std::uniform_int_distribution<std::size_t> dis(0, books_.size() - 1);
+			instrument_ = dis(gen_);
+		}
+	}
+
 	void update_trend() {
 		// 1/1000 probability to re-generate trend
-		static std::uniform_int_distribution<> dis(0, 1000 * 2 - 1);
+		std::uniform_int_distribution<> dis(0, 1000 * 2 - 1);
 		int r = dis(gen_);
 		if (r <= 1) {
 			trend_ = r == 0;
@@ -101,41 +202,46 @@ private:
 	// generate random trend of order numbers: increase(true) or decrease(false)
 	// probability: p(increase) / p(decrease) = book_size_ / (buy_book_size + sell_book_size)
 	int random_action() {
-		auto buy_size = std::get<Orders<BuyOrder>>(orders_).size();
-		auto sell_size = std::get<Orders<SellOrder>>(orders_).size();
+		auto buy_size = std::get<Orders<BuyOrder>>(orders()).size();
+		auto sell_size = std::get<Orders<SellOrder>>(orders()).size();
 		std::uniform_int_distribution<unsigned> dis(0, buy_size + sell_size + book_size_);
 		return dis(gen_) < book_size_;
 	}
 
 	// generate random action whether to put a immediately matched order
-	// probability: p(match) = 1/4
+	// probability: p(match) = 1 / match_odds
 	bool random_action_match() {
-		static std::uniform_int_distribution<> dis(0, 3);
+		std::uniform_int_distribution<> dis(0, profile_.match_odds - 1);
 		return dis(gen_) == 0;
 	}
 
 	// generate random order type: buy(true) or sell(false)
 	// probability: p(buy) / p(sell) = sell_book_size / buy_book_size
 	bool random_buysell() {
-		auto buy_size = std::get<Orders<BuyOrder>>(orders_).size();
-		auto sell_size = std::get<Orders<SellOrder>>(orders_).size();
+		auto buy_size = std::get<Orders<BuyOrder>>(orders()).size();
+		auto sell_size = std::get<Orders<SellOrder>>(orders()).size();
 		std::uniform_int_distribution<unsigned> dis(0, buy_size + sell_size);
 		return dis(gen_) < sell_size;
 	}
 
 	// generate random order quantity
-	// probability: uniform in [1, 100]
+	// probability: uniform in [min_quantity, max_quantity]
 	Order::QuantityType random_quantity() {
-		static std::uniform_int_distribution<Order::QuantityType> dis(1, 100);
+		std::uniform_int_distribution<Order::QuantityType> dis(profile_.min_quantity, profile_.max_quantity);
 		return dis(gen_);
 	}
 
+	// generate random distance of a price from the top of a book, scaled by `scale`
+	Order::PriceType random_diff(double scale) {
+		return static_cast<Order::PriceType>(random_half_poisson(INITIAL_PRICE) * scale);
+	}
+
 	// generate random order price that will not be matched immediately
 	// T can be BuyOrder or SellOrder
 	template <class O>
 	Order::PriceType random_price() {
-		Order::PriceType diff = random_half_poisson(INITIAL_PRICE);
-		Order::PriceType price = std::get<Orders<O>>(orders_).top_price();
+		Order::PriceType diff = random_diff(profile_.dispersion);
+		Order::PriceType price = std::get<Orders<O>>(orders()).top_price();
 		if (std::is_same<O, BuyOrder>()) {
 			return safe_price_minus(price, trend_ ? diff : diff * 2);
 		} else {
@@ -147,10 +253,10 @@ private:
 	// T can be BuyOrder or SellOrder
 	template <class O>
 	Order::PriceType match_price() {
-		Order::PriceType diff = random_half_poisson(INITIAL_PRICE);
+		Order::PriceType diff = random_diff(profile_.dispersion * profile_.sweep);
 		Order::PriceType price = std::is_same<O, BuyOrder>()
-			? std::get<Orders<SellOrder>>(orders_).top_price()
-			: std::get<Orders<BuyOrder>>(orders_).top_price();
+			? std::get<Orders<SellOrder>>(orders()).top_price()
+			: std::get<Orders<BuyOrder>>(orders()).top_price();
 		if (std::is_same<O, BuyOrder>()) {
 			return price + (trend_ ? diff * 2 : diff);
 		} else {
@@ -159,10 +265,16 @@ private:
 	}
 
 	// generate random order price as an indication to cancel orders_
+	// probability: close to the bottom of the book, or to the top with cancel_top
 	template <class O>
 	Order::PriceType random_cancel_price() {
-		Order::PriceType bottom_price = std::get<Orders<O>>(orders_).rbegin()->price();
-		Order::PriceType top_price = std::get<Orders<O>>(orders_).top_price();
+		Order::PriceType bottom_price = std::get<Orders<O>>(orders()).rbegin()->price();
+		Order::PriceType top_price = std::get<Orders<O>>(orders()).top_price();
+		if (profile_.cancel_top) {
+			return std::is_same<O, BuyOrder>()
+				? std::max(bottom_price, top_price - random_half_poisson(top_price - bottom_price))
+				: std::min(bottom_price, top_price + random_half_poisson(bottom_price - top_price));
+		}
 		return std::is_same<O, BuyOrder>()
 			? std::min(top_price, bottom_price + random_half_poisson(top_price - bottom_price))
 			: std::max(top_price, bottom_price - random_half_poisson(bottom_price - top_price));
@@ -170,7 +282,7 @@ private:
 
 	template <class O>
 	void match(O &order) {
-		auto &opposite_book = std::get<Orders<typename OppositeOrder<O>::Type>>(orders_);
+		auto &opposite_book = std::get<Orders<typename OppositeOrder<O>::Type>>(orders());
 		while (!opposite_book.empty() && opposite_book.begin()->is_compatible_with(order) && order.quantity() > 0) {
 			auto matched_order = opposite_book.begin();
 			if (order.quantity() >= matched_order->quantity()) {
@@ -189,11 +301,12 @@ private:
 			std::is_same<O, BuyOrder>() ? Request::BUY : Request::SELL,
 			order.id(),
 			order.price(),
-			order.quantity());
+			order.quantity(),
+			instrument());
 		O matched = order;
 		match(matched);
 		if (matched.quantity() > 0) {
-			std::get<Orders<O>>(orders_).insert(matched);
+			std::get<Orders<O>>(orders()).insert(matched);
 		}
 		handler_.process(request);
 	}
@@ -205,12 +318,13 @@ private:
 
 	template <class O>
 	void place_match() {
-		place<O>({next_id(), match_price<O>(), random_quantity()});
+		Order::PriceType price = match_price<O>();
+		place<O>({next_id(), price, static_cast<Order::QuantityType>(random_quantity() * profile_.sweep)});
 	}
 
 	template <class O>
 	void cancel() {
-		auto &book = std::get<Orders<O>>(orders_);
+		auto &book = std::get<Orders<O>>(orders());
 		if (book.empty()) {
 			return;
 		}
@@ -220,7 +334,8 @@ private:
 		book.erase(it);
 		Request::Cancel request(
 			std::is_same<O, BuyOrder>() ? Request::BUY : Request::SELL,
-			id);
+			id,
+			instrument());
 		handler_.process(request);
 	}
 };
@@ -228,6 +343,10 @@ private:
 }
 
 using generator::Generator;
+using generator::Partition;
+using generator::Profile;
+using generator::profile;
+using generator::derive_seed;
 
 }
 }
@@ -7,61 +7,56 @@
 #include <chrono>
 #include <iomanip>
 #include <ios>
+#include "benchmark/histogram.h"
 
+/// \remarks Throughput and latency of a benchmark run. Latencies are in nanoseconds, recorded into a `Histogram` with `PIEX_OPTION_BENCHMARK_LATENCY_DIGITS` significant digits (default: 3)
 class Stats {
 public:
-	Stats() : latencies(LATENCY_VALUES + 1) {};
+#if PIEX_OPTION_BENCHMARK_LATENCY_DIGITS > 0
+	Stats() : latencies(PIEX_OPTION_BENCHMARK_LATENCY_DIGITS) {};
+#else
+	Stats() : latencies(3) {};
+#endif
 	void start() {
 		start_time = std::chrono::high_resolution_clock::now();
 	}
+	/// \param latency The latency of a request in nanoseconds
 	void add_entry(std::uint64_t latency) {
-		max_latency = std::max(max_latency, latency);
-		if (latency >= LATENCY_VALUES) {
-			latency = LATENCY_VALUES;
-		}
-		total_latency += latency;
-		total_latency2 += latency * latency;
-		++latencies[latency];
-		++order_num;
+		latencies.record(latency);
 	}
 	void end() {
 		end_time = std::chrono::high_resolution_clock::now();
 	}
+	/// \effects Add the latencies of `other` and extend the run to cover both
+	void merge(const Stats &other) {
+		latencies.merge(other.latencies);
+		start_time = std::min(start_time, other.start_time);
+		end_time = std::max(end_time, other.end_time);
+	}
 	double throughput_average() const {
-		return static_cast<double>(order_num) * 1000 * 1000 * 1000 / std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
+		return static_cast<double>(latencies.count()) * 1000 * 1000 * 1000 / std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
 	}
 	double latency_average() const {
-		return static_cast<double>(total_latency) / order_num;
+		return latencies.mean();
 	}
 	double latency_stddev() const {
-		return std::sqrt((total_latency2 - static_cast<double>(total_latency * total_latency) / order_num) / order_num);
+		return latencies.stddev();
 	}
+	/// \returns Pairs of percentiles and the latency in nanoseconds under which that percentage of requests completed, ending with the exact maximum
 	std::vector<std::pair<double, std::uint64_t>> latency_distribution() const {
 		std::vector<std::pair<double, std::uint64_t>> ret;
-		uint64_t cursor = 0;
-		std::uint64_t scanned_order_num = 0;
 		for (double percentile : PERCENTILES) {
-			while (cursor <= LATENCY_VALUES && scanned_order_num * 100 < order_num * percentile) {
-				scanned_order_num += latencies[cursor];
-				++cursor;
-			}
-			if (cursor == LATENCY_VALUES + 1) {
-				ret.push_back(std::make_pair(percentile, static_cast<uint64_t>(-1)));
-			} else {
-				ret.push_back(std::make_pair(percentile, cursor - 1));
-			}
+			ret.push_back(std::make_pair(percentile, latencies.value_at_percentile(percentile)));
 		}
-		ret.push_back(std::make_pair(100, max_latency));
+		ret.push_back(std::make_pair(100, latencies.max()));
 		return ret;
 	}
+	const piex::benchmark::Histogram &histogram() const {
+		return latencies;
+	}
 private:
-	constexpr static int LATENCY_VALUES = 1000000;
-	constexpr static double PERCENTILES[] = {0.1, 1, 5, 25, 50, 75, 95, 99, 99.9, 99.99};
-	std::uint64_t order_num = 0;
-	std::uint64_t total_latency = 0;
-	std::uint64_t total_latency2 = 0;
-	std::uint64_t max_latency = 0;
-	std::vector<std::uint64_t> latencies;
+	constexpr static double PERCENTILES[] = {0.1, 1, 5, 25, 50, 75, 95, 99, 99.9, 99.99, 99.999, 99.9999};
+	piex::benchmark::Histogram latencies;
 	std::chrono::high_resolution_clock::time_point start_time;
 	std::chrono::high_resolution_clock::time_point end_time;
 };
@@ -73,19 +68,18 @@ std::ostream &operator<<(std::ostream &os, const Stats &stats) {
 		<< "Throughput:" << std::endl
 		<< "    Average: " << std::fixed << stats.throughput_average() << " req/s" << std::endl
 		<< std::endl
+		<< std::setprecision(3)
 		<< "Latency:" << std::endl
-		<< "    Average: " << std::fixed << stats.latency_average() / 10.0 << " ms" << std::endl
-		<< "    Standard Deviation: " << stats.latency_stddev() / 10.0 << " ms" << std::endl
+		<< "    Average: " << std::fixed << stats.latency_average() / 1000.0 << " us" << std::endl
+		<< "    Standard Deviation: " << stats.latency_stddev() / 1000.0 << " us" << std::endl
 		<< "    Distribution:" << std::endl;
 	os << std::setprecision(precision);
 	auto distribution = stats.latency_distribution();
 	for (auto &entry : distribution) {
-		if (entry.second != static_cast<uint64_t>(-1)) {
-			os
-				<< std::setw(8) << ""
-				<< std::setw(5) << std::setprecision(precision) << std::defaultfloat << entry.first << " %  < "
-				<< std::setw(8)	<< std::setprecision(1) << std::fixed << entry.second / 10.0 << " ms" << std::endl;
-		}
+		os
+			<< std::setw(8) << ""
+			<< std::setw(8) << std::setprecision(precision) << std::defaultfloat << entry.first << " %  <= "
+			<< std::setw(12) << std::setprecision(3) << std::fixed << entry.second / 1000.0 << " us" << std::endl;
 	}
 	os << std::setprecision(precision);
 	return os;
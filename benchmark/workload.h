@@ -0,0 +1,215 @@
+#ifndef PIEX_HEADER_BENCHMARK_WORKLOAD
+#define PIEX_HEADER_BENCHMARK_WORKLOAD
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include "src/packets/packets.h"
+
+// must be little-endian
+
+namespace piex {
+namespace benchmark {
+namespace workload {
+
+constexpr std::uint64_t MAGIC = 0x444c4b5758454950; // "PIEXWKLD"
+constexpr std::uint32_t VERSION = 2;
+
+/// \remarks Layout of a workload file: `Header`, followed by `size` bytes holding `count` requests encoded as on the wire by `PIEX_OPTION_PACKETS`. Requests are back to back if `slot` is 0, otherwise each takes `slot` bytes, zero-padded, so that the position of every request is known in advance. Packets are multiples of 8 bytes, so every request is aligned and can be processed in place.
+/// \remarks Workloads generated by several threads are made of `shards` streams of requests, interleaved in blocks.
+struct Header {
+	std::uint64_t magic;
+	std::uint32_t version;
+	std::int32_t packets;
+	std::uint32_t place_size;
+	std::uint32_t cancel_size;
+	std::uint32_t slot;
+	std::uint32_t shards;
+	std::uint64_t count;
+	std::uint64_t size;
+	// parameters the requests were generated with, informative only
+	std::uint64_t seed;
+	std::uint64_t book_size;
+	std::uint64_t instruments;
+};
+
+static_assert(sizeof(Header) % alignof(Request::Data) == 0, "requests shall be aligned");
+static_assert(sizeof(Request::Place) % alignof(Request::Data) == 0 && sizeof(Request::Cancel) % alignof(Request::Data) == 0, "requests shall be aligned");
+
+struct Parameters {
+	std::uint64_t seed;
+	std::uint64_t book_size;
+	std::uint64_t instruments;
+};
+
+/// \returns The header of an empty workload
+/// \param slot Bytes taken by each request, 0 for requests back to back
+inline Header header(const Parameters &parameters, std::uint32_t slot = 0, std::uint32_t shards = 1) {
+	return {
+		MAGIC,
+		VERSION,
+		PIEX_OPTION_PACKETS,
+		sizeof(Request::Place),
+		sizeof(Request::Cancel),
+		slot,
+		shards,
+		0,
+		0,
+		parameters.seed,
+		parameters.book_size,
+		parameters.instruments,
+	};
+}
+
+/// \returns The slot size fitting any request
+constexpr std::uint32_t slot() {
+	return std::max(sizeof(Request::Place), sizeof(Request::Cancel));
+}
+
+/// \remarks A workload file of requests back to back, being written. Requests are buffered and written in large blocks, and the header is brought up to date on every `flush`, so that the file holds a valid workload of all requests appended before the last `flush`
+class Writer {
+public:
+	/// \effects Create or truncate the file at `path` and write the header of an empty workload
+	Writer(const char *path, const Parameters &parameters) : header_(header(parameters)) {
+		fd_ = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd_ < 0) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+		write_header();
+	}
+	Writer(const Writer &) = delete;
+	~Writer() {
+		::close(fd_);
+	}
+
+	template <class R>
+	void append(const R &request) {
+		if (size_ + sizeof(request) > BUFFER_SIZE) {
+			write_buffer();
+		}
+		std::memcpy(buf_ + size_, &request, sizeof(request));
+		size_ += sizeof(request);
+		++count_;
+	}
+
+	/// \effects Write buffered requests and update the header
+	void flush() {
+		write_buffer();
+		if (header_.count != count_) {
+			header_.count = count_;
+			write_header();
+		}
+	}
+private:
+	static constexpr std::size_t BUFFER_SIZE = 1 << 20;
+	Header header_;
+	int fd_;
+	char buf_[BUFFER_SIZE];
+	std::size_t size_ = 0;
+	std::uint64_t count_ = 0;
+
+	void write_buffer() {
+		std::size_t nbytes_written = 0;
+		while (nbytes_written < size_) {
+			ssize_t ret = ::pwrite(fd_, buf_ + nbytes_written, size_ - nbytes_written, sizeof(Header) + header_.size + nbytes_written);
+			if (ret < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				throw std::runtime_error(std::strerror(errno));
+			}
+			nbytes_written += ret;
+		}
+		header_.size += size_;
+		size_ = 0;
+	}
+	void write_header() {
+		if (::pwrite(fd_, &header_, sizeof(header_), 0) != static_cast<ssize_t>(sizeof(header_))) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+	}
+};
+
+/// \remarks A read-only memory mapping of a workload file
+class Mapping {
+public:
+	/// \effects Map the workload at `path` and validate its header
+	explicit Mapping(const char *path) {
+		int fd = ::open(path, O_RDONLY);
+		if (fd < 0) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+		struct stat st;
+		if (::fstat(fd, &st) < 0) {
+			::close(fd);
+			throw std::runtime_error(std::strerror(errno));
+		}
+		size_ = st.st_size;
+		if (size_ < sizeof(Header)) {
+			::close(fd);
+			throw std::runtime_error("workload truncated");
+		}
+		void *addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+		::close(fd);
+		if (addr == MAP_FAILED) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+		data_ = static_cast<const char *>(addr);
+		try {
+			validate();
+		} catch (...) {
+			::munmap(addr, size_);
+			throw;
+		}
+	}
+	Mapping(const Mapping &) = delete;
+	~Mapping() {
+		::munmap(const_cast<char *>(data_), size_);
+	}
+	const Header &header() const {
+		return *reinterpret_cast<const Header *>(data_);
+	}
+	/// \returns The first byte of the requests
+	const char *begin() const {
+		return data_ + sizeof(Header);
+	}
+	const char *end() const {
+		return begin() + header().size;
+	}
+	/// \returns The number of bytes from a request of `type` to the next
+	std::size_t stride(Request::Type type) const {
+		return header().slot ? header().slot : Request::size(type);
+	}
+private:
+	const char *data_;
+	std::size_t size_;
+
+	void validate() {
+		const Header &h = header();
+		if (h.magic != MAGIC || h.version != VERSION) {
+			throw std::runtime_error("workload format mismatch");
+		}
+		if (h.packets != PIEX_OPTION_PACKETS || h.place_size != sizeof(Request::Place) || h.cancel_size != sizeof(Request::Cancel)) {
+			throw std::runtime_error("workload encoded with other packets");
+		}
+		if (h.slot && (h.slot % alignof(Request::Data) || h.slot < slot() || h.size != h.count * h.slot)) {
+			throw std::runtime_error("workload format mismatch");
+		}
+		if (size_ - sizeof(Header) < h.size) {
+			throw std::runtime_error("workload truncated");
+		}
+	}
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,11 @@
+#include "config/values.h"
+
+#define PIEX_OPTION_SERVER PIEX_OPTION_TRIVIAL
+#define PIEX_OPTION_SOCKET PIEX_OPTION_SOCKET_BUSY_POLL
+#define PIEX_OPTION_SOCKET_BUFFER_SIZE 4096
+#define PIEX_OPTION_SOCKET_BUSY_POLL_SPINS 10000
+#define PIEX_OPTION_SOCKET_BUSY_POLL_USEC 50
+#define PIEX_OPTION_ORDER_BOOK PIEX_OPTION_TRIVIAL
+#define PIEX_OPTION_PACKETS PIEX_OPTION_TRIVIAL
+
+#define PIEX_OPTION_BENCHMARK_REQUEST_WINDOW_SIZE 1024
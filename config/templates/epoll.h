@@ -0,0 +1,13 @@
+#include "config/values.h"
+
+#define PIEX_OPTION_SERVER PIEX_OPTION_SERVER_EPOLL
+#define PIEX_OPTION_SERVER_EPOLL_EVENTS 64
+#define PIEX_OPTION_SERVER_EPOLL_BUFFER_SIZE 65536
+#define PIEX_OPTION_SOCKET PIEX_OPTION_SOCKET_BUFFERED
+#define PIEX_OPTION_SOCKET_BUFFER_SIZE 4096
+#define PIEX_OPTION_ORDER_BOOK PIEX_OPTION_TRIVIAL
+#define PIEX_OPTION_PACKETS PIEX_OPTION_TRIVIAL
+#define PIEX_OPTION_NSEMAPHORE PIEX_OPTION_NSEMAPHORE_FUTEX
+
+#define PIEX_OPTION_BENCHMARK_REQUEST_WINDOW_SIZE 1024
+#define PIEX_OPTION_BENCHMARK_RECEIVER_THREAD 1
@@ -1,10 +1,14 @@
 #include "config/values.h"
 
+#define PIEX_OPTION_SERVER PIEX_OPTION_TRIVIAL
 #define PIEX_OPTION_SOCKET PIEX_OPTION_SOCKET_MULTITHREADED_ATOMIC_FLUSH
 #define PIEX_OPTION_SOCKET_BUFFER_SIZE 4096
 #define PIEX_OPTION_SOCKET_FLUSH_THRESHOLD 2048
+#define PIEX_OPTION_SOCKET_FLUSH_LATENCY_USEC 50
 #define PIEX_OPTION_ORDER_BOOK PIEX_OPTION_TRIVIAL
 #define PIEX_OPTION_PACKETS PIEX_OPTION_TRIVIAL
 #define PIEX_OPTION_NSEMAPHORE PIEX_OPTION_NSEMAPHORE_FUTEX
+#define PIEX_OPTION_NSEMAPHORE_SPINS 4096
+#define PIEX_OPTION_NSEMAPHORE_SPIN_USEC 10
 
 #define PIEX_OPTION_BENCHMARK_REQUEST_WINDOW_SIZE 1024
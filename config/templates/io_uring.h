@@ -0,0 +1,11 @@
+#include "config/values.h"
+
+#define PIEX_OPTION_SERVER PIEX_OPTION_TRIVIAL
+#define PIEX_OPTION_SOCKET PIEX_OPTION_SOCKET_IO_URING
+#define PIEX_OPTION_SOCKET_BUFFER_SIZE 4096
+#define PIEX_OPTION_SOCKET_IO_URING_BUFFERS 64
+#define PIEX_OPTION_SOCKET_IO_URING_SQPOLL 0
+#define PIEX_OPTION_ORDER_BOOK PIEX_OPTION_TRIVIAL
+#define PIEX_OPTION_PACKETS PIEX_OPTION_TRIVIAL
+
+#define PIEX_OPTION_BENCHMARK_REQUEST_WINDOW_SIZE 1024
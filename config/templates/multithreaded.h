@@ -1,5 +1,6 @@
 #include "config/values.h"
 
+#define PIEX_OPTION_SERVER PIEX_OPTION_TRIVIAL
 #define PIEX_OPTION_SOCKET PIEX_OPTION_SOCKET_MULTITHREADED
 #define PIEX_OPTION_SOCKET_BUFFER_SIZE 4096
 #define PIEX_OPTION_ORDER_BOOK PIEX_OPTION_TRIVIAL
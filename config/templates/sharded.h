@@ -0,0 +1,17 @@
+#include "config/values.h"
+
+#define PIEX_OPTION_SERVER PIEX_OPTION_SERVER_PIPELINED
+#define PIEX_OPTION_SERVER_QUEUE_SIZE 4096
+#define PIEX_OPTION_SERVER_SHARDS 4
+#define PIEX_OPTION_SERVER_NETWORK_CPU -1
+#define PIEX_OPTION_SERVER_MATCHING_CPU -1
+#define PIEX_OPTION_SERVER_WRITER_CPU -1
+#define PIEX_OPTION_SERVER_SPINS 1000
+#define PIEX_OPTION_SERVER_IMPLICIT_FLUSH 1
+#define PIEX_OPTION_SERVER_FLUSH_DEADLINE_USEC 100
+#define PIEX_OPTION_SOCKET PIEX_OPTION_SOCKET_BUFFERED
+#define PIEX_OPTION_SOCKET_BUFFER_SIZE 4096
+#define PIEX_OPTION_ORDER_BOOK PIEX_OPTION_TRIVIAL
+#define PIEX_OPTION_PACKETS PIEX_OPTION_TRIVIAL
+
+#define PIEX_OPTION_BENCHMARK_REQUEST_WINDOW_SIZE 1024
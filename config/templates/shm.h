@@ -0,0 +1,10 @@
+#include "config/values.h"
+
+#define PIEX_OPTION_SERVER PIEX_OPTION_TRIVIAL
+#define PIEX_OPTION_SOCKET PIEX_OPTION_SOCKET_SHM
+#define PIEX_OPTION_SOCKET_SHM_SIZE 65536
+#define PIEX_OPTION_SOCKET_SHM_SPINS 1000
+#define PIEX_OPTION_ORDER_BOOK PIEX_OPTION_TRIVIAL
+#define PIEX_OPTION_PACKETS PIEX_OPTION_TRIVIAL
+
+#define PIEX_OPTION_BENCHMARK_REQUEST_WINDOW_SIZE 1024
@@ -0,0 +1,12 @@
+#include "config/values.h"
+
+#define PIEX_OPTION_SERVER PIEX_OPTION_TRIVIAL
+#define PIEX_OPTION_SERVER_IMPLICIT_FLUSH 1
+#define PIEX_OPTION_SERVER_FLUSH_DEADLINE_USEC 100
+#define PIEX_OPTION_SOCKET PIEX_OPTION_SOCKET_BUFFERED
+#define PIEX_OPTION_SOCKET_BUFFER_SIZE 65536
+#define PIEX_OPTION_SOCKET_ZEROCOPY_SIZE 16384
+#define PIEX_OPTION_ORDER_BOOK PIEX_OPTION_TRIVIAL
+#define PIEX_OPTION_PACKETS PIEX_OPTION_TRIVIAL
+
+#define PIEX_OPTION_BENCHMARK_REQUEST_WINDOW_SIZE 1024
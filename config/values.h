@@ -4,12 +4,20 @@
 // to avoid false positive comparsion when an option is misspelled
 #define PIEX_OPTION_TRIVIAL -1
 
+// server
+
+#define PIEX_OPTION_SERVER_PIPELINED 1
+#define PIEX_OPTION_SERVER_EPOLL 2
+
 // socket
 
 #define PIEX_OPTION_SOCKET_BUFFERED 1
 #define PIEX_OPTION_SOCKET_MULTITHREADED 2
 #define PIEX_OPTION_SOCKET_MULTITHREADED_ATOMIC 3
 #define PIEX_OPTION_SOCKET_MULTITHREADED_ATOMIC_FLUSH 4
+#define PIEX_OPTION_SOCKET_IO_URING 5
+#define PIEX_OPTION_SOCKET_BUSY_POLL 6
+#define PIEX_OPTION_SOCKET_SHM 7
 
 // order-book
 
@@ -24,5 +32,6 @@
 // nsemaphore
 
 #define PIEX_OPTION_NSEMAPHORE_FUTEX 1
+#define PIEX_OPTION_NSEMAPHORE_EVENTFD 2
 
 #endif
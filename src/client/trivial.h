@@ -43,51 +43,65 @@ public:
 		socket.flush();
 	}
 
+	/// \effects Send requests in buffer to server immediately, without asking the server to flush its responses
+	/// \remarks Servers with `PIEX_OPTION_SERVER_IMPLICIT_FLUSH` respond once they run out of requests
+	void send() {
+		socket.flush();
+	}
+
 	/// \effects Place an order
 	/// \requires Type `U` shall be `BuyOrder` or `SellOrder`
+	/// \param instrument The instrument to trade
 	template <class U>
-	void place(const U &order) {
+	void place(const U &order, const Order::InstrumentIdType &instrument = 0) {
 		Request::Place request(
 			std::is_same<U, BuyOrder>() ? Request::BUY : Request::SELL,
 			order.id(),
 			order.price(),
-			order.quantity());
+			order.quantity(),
+			instrument);
 		process(request);
 	}
 
 	/// \effects Place a buy order
 	/// \param order Buy order to place
-	void buy(const BuyOrder &order) {
-		place(order);
+	/// \param instrument The instrument to trade
+	void buy(const BuyOrder &order, const Order::InstrumentIdType &instrument = 0) {
+		place(order, instrument);
 	}
 
 	/// \effects Place a sell order
 	/// \param order Sell order to place
-	void sell(const SellOrder &order) {
-		place(order);
+	/// \param instrument The instrument to trade
+	void sell(const SellOrder &order, const Order::InstrumentIdType &instrument = 0) {
+		place(order, instrument);
 	}
 
 	/// \effects Cancel an order
 	/// \requires Type `T` shall satisfy `Order` and is the correct type of the order to cancel
 	/// \param id The id of the order to cancel
+	/// \param instrument The instrument of the order
 	template <class U>
-	void cancel(const Order::IdType &id) {
+	void cancel(const Order::IdType &id, const Order::InstrumentIdType &instrument = 0) {
 		Request::Cancel request(
 			std::is_same<U, BuyOrder>() ? Request::BUY : Request::SELL,
-			id);
+			id,
+			instrument);
 		process(request);
 	}
 
 	/// \effects Cancel a buy order
 	/// \param id The id of the order to cancel
-	void cancel_buy(const Order::IdType &id) {
-		cancel<BuyOrder>(id);
+	/// \param instrument The instrument of the order
+	void cancel_buy(const Order::IdType &id, const Order::InstrumentIdType &instrument = 0) {
+		cancel<BuyOrder>(id, instrument);
 	}
 
 	/// \effects Cancel a sell order
 	/// \param id The id of the order to cancel
-	void cancel_sell(const Order::IdType &id) {
-		cancel<SellOrder>(id);
+	/// \param instrument The instrument of the order
+	void cancel_sell(const Order::IdType &id, const Order::InstrumentIdType &instrument = 0) {
+		cancel<SellOrder>(id, instrument);
 	}
 
 	/// \effects Read responses from socket and notify `handler_`
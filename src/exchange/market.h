@@ -0,0 +1,103 @@
+#ifndef PIEX_HEADER_EXCHANGE_MARKET
+#define PIEX_HEADER_EXCHANGE_MARKET
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "src/exchange/exchange.h"
+#include "src/packets/packets.h"
+#include "src/snapshot/snapshot.h"
+#include "src/order/order.h"
+
+namespace piex {
+
+/// \remarks Routes requests to one `Exchange` per instrument. Exchanges (and their order books) are created on the first request of an instrument.
+/// \requires Type T shall satisfy `EventHandler`
+template <class T>
+class Market {
+public:
+	using EventHandlerType = T;
+	explicit Market(EventHandlerType &handler) : handler_(handler) {}
+
+	/// \effects Process a request on the exchange of its instrument
+	/// \requires Type `R` shall be `Request::Place` or `Request::Cancel`
+	template <class R>
+	void process_request(const R &request) {
+		++sequence_;
+		exchange(request.instrument()).process_request(request);
+	}
+
+	/// \returns The exchange of `instrument`, creating it if necessary
+	Exchange<EventHandlerType> &exchange(Order::InstrumentIdType instrument) {
+		if (instrument >= exchanges_.size()) {
+			exchanges_.resize(instrument + 1);
+		}
+		std::unique_ptr<Exchange<EventHandlerType>> &exchange = exchanges_[instrument];
+		if (!exchange) {
+			exchange = std::make_unique<Exchange<EventHandlerType>>(handler_, instrument);
+		}
+		return *exchange;
+	}
+
+	/// \returns The number of instruments that have received requests
+	std::size_t active_instruments() const {
+		std::size_t n = 0;
+		for (const auto &exchange : exchanges_) {
+			n += static_cast<bool>(exchange);
+		}
+		return n;
+	}
+
+	/// \returns The number of requests processed, including those restored from a snapshot
+	std::uint64_t sequence() const {
+		return sequence_;
+	}
+
+	/// \returns A snapshot file sized for the order books of all active instruments, to be filled by `save`
+	snapshot::File open_snapshot(const char *path) const {
+		std::uint64_t orders = 0;
+		for (const auto &exchange : exchanges_) {
+			if (exchange) {
+				orders += exchange->size();
+			}
+		}
+		return snapshot::File(path, sequence_, active_instruments(), orders);
+	}
+
+	/// \effects Append the order books of all active instruments to `file`, one section each
+	void save(snapshot::File &file) const {
+		for (const auto &exchange : exchanges_) {
+			if (exchange) {
+				exchange->save(file);
+			}
+		}
+	}
+
+	/// \effects Write a snapshot of the order books of all active instruments to `path`
+	/// \param path The snapshot file
+	void save(const char *path) const {
+		snapshot::File file = open_snapshot(path);
+		save(file);
+		file.commit();
+	}
+
+	/// \effects Replace all order books and the sequence number with the snapshot at `path`
+	/// \param path The snapshot file
+	/// \remarks Requests after `sequence()` in the request log shall be replayed to catch up
+	void restore(const char *path) {
+		snapshot::Mapping mapping(path);
+		exchanges_.clear();
+		for (const snapshot::Section &section : mapping.sections()) {
+			exchange(section.instrument).restore(section);
+		}
+		sequence_ = mapping.header().sequence;
+	}
+private:
+	EventHandlerType &handler_;
+	std::vector<std::unique_ptr<Exchange<EventHandlerType>>> exchanges_;
+	std::uint64_t sequence_ = 0;
+};
+
+}
+
+#endif
@@ -1,6 +1,7 @@
 #include "src/packets/packets.h"
 #include "src/order-book/order-book.h"
 #include "src/order/order.h"
+#include "src/snapshot/snapshot.h"
 
 namespace piex {
 
@@ -9,11 +10,14 @@ template <class T>
 class Exchange {
 public:
 	using EventHandlerType = T;
-	explicit Exchange(EventHandlerType &handler) : handler_(handler) {}
+	/// \param handler The handler to notify of responses
+	/// \param instrument The instrument traded on this exchange. Responses are tagged with it
+	explicit Exchange(EventHandlerType &handler, Order::InstrumentIdType instrument = 0) : handler_(handler), instrument_(instrument) {}
 
 	/// \effects Process a order placement. This shall match order if possible and insert it to order book if not completely matched. `handler_` will be notified when finished
 	/// \param request The order placement request
 	void process_request(const Request::Place &request) {
+		++sequence_;
 		if (request.order_type() == Request::BUY) {
 			const Order &order = request.order();
 			insert_order_to_book(static_cast<const BuyOrder &>(order), buy_book_, sell_book_);
@@ -26,6 +30,7 @@ public:
 	/// \effects Process a order cancel. This shall remove order from the book. `handler_` will be notified of the results when finished.
 	/// \param request The order cancel request
 	void process_request(const Request::Cancel &request) {
+		++sequence_;
 		if (request.order_type() == Request::BUY) {
 			remove_order_from_book(request, buy_book_);
 		} else {
@@ -33,10 +38,63 @@ public:
 		}
 	}
 
+	/// \returns The number of requests processed, including those restored from a snapshot
+	std::uint64_t sequence() const {
+		return sequence_;
+	}
+
+	const Order::InstrumentIdType &instrument() const {
+		return instrument_;
+	}
+
+	/// \returns The number of orders in both order books
+	std::uint64_t size() const {
+		return buy_book_.size() + sell_book_.size();
+	}
+
+	/// \returns A snapshot file sized for both order books, to be filled by `save`
+	snapshot::File open_snapshot(const char *path) const {
+		return snapshot::File(path, sequence_, 1, size());
+	}
+
+	/// \effects Append both order books to `file` as one section
+	void save(snapshot::File &file) const {
+		file.write(instrument_, buy_book_, sell_book_);
+	}
+
+	/// \effects Write a snapshot of both order books to `path`
+	/// \param path The snapshot file
+	void save(const char *path) const {
+		snapshot::File file = open_snapshot(path);
+		save(file);
+		file.commit();
+	}
+
+	/// \effects Replace both order books with a section of a mapped snapshot
+	void restore(const snapshot::Section &section) {
+		buy_book_.load(section.buy_begin, section.buy_end);
+		sell_book_.load(section.sell_begin, section.sell_end);
+	}
+
+	/// \effects Replace both order books and the sequence number with the snapshot at `path`
+	/// \param path The snapshot file
+	/// \remarks Requests after `sequence()` in the request log shall be replayed to catch up
+	void restore(const char *path) {
+		snapshot::Mapping mapping(path);
+		for (const snapshot::Section &section : mapping.sections()) {
+			if (section.instrument == instrument_) {
+				restore(section);
+			}
+		}
+		sequence_ = mapping.header().sequence;
+	}
+
 private:
 	EventHandlerType &handler_;
+	Order::InstrumentIdType instrument_;
 	OrderBook<BuyOrder> buy_book_;
 	OrderBook<SellOrder> sell_book_;
+	std::uint64_t sequence_ = 0;
 
 	/// \effects Match a order with existing ones if possible. Then insert it into order book if not completely matched. `handler_` will be notified when finished.
 	/// \param request_order The order to insert
@@ -58,7 +116,8 @@ private:
 					order,
 					order.quantity(),
 					opposite_book.empty() ? 0 : opposite_book.top().price(),
-					order_book.empty() ? 0 : order_book.top().price()});
+					order_book.empty() ? 0 : order_book.top().price(),
+					instrument_});
 				order.quantity() = 0;
 				break;
 			}
@@ -70,13 +129,14 @@ private:
 				order,
 				opposite_top.quantity(),
 				opposite_book.empty() ? 0 : opposite_book.top().price(),
-				order.quantity() > 0 ? order.price() : (order_book.empty() ? 0 : order_book.top().price())
+				order.quantity() > 0 ? order.price() : (order_book.empty() ? 0 : order_book.top().price()),
+				instrument_
 			});
 		}
 		if (order.quantity() > 0) {
 			success = order_book.insert(order);
 		}
-		handler_.on_place({success, order.id()});
+		handler_.on_place({success, order.id(), instrument_});
 	}
 
 	/// \effects Remove a order from the order book. `handler_` will be notified of the results when finished.
@@ -85,7 +145,7 @@ private:
 	template <class U>
 	void remove_order_from_book(const Request::Cancel &request, OrderBook<U> &order_book) {
 		bool success = order_book.remove(request.id());
-		handler_.on_cancel({success, request.id()});
+		handler_.on_cancel({success, request.id(), instrument_});
 	}
 };
 }
@@ -1,3 +1,4 @@
+#include <cstdlib>
 #include <iostream>
 #include <stdexcept>
 #include "src/server/server.h"
@@ -7,7 +8,15 @@ int main(int argc, const char *argv[]) {
 
 	const char *host = "127.0.0.1";
 	const char *port = "3000";
+	const char *snapshot_path = nullptr;
+	std::uint64_t snapshot_interval = 1000000;
 	switch (argc) {
+	case 5:
+		snapshot_interval = std::strtoull(argv[4], nullptr, 0);
+		[[fallthrough]];
+	case 4:
+		snapshot_path = argv[3];
+		[[fallthrough]];
 	case 3:
 		host = argv[2];
 		[[fallthrough]];
@@ -17,10 +26,13 @@ int main(int argc, const char *argv[]) {
 	case 1:
 		break;
 	default:
-		std::cerr << "Usage: " << argv[0] << " [port] [host]" << std::endl;
+		std::cerr << "Usage: " << argv[0] << " [port] [host] [snapshot_path] [snapshot_interval]" << std::endl;
 		return 1;
 	}
 	try {
+		if (snapshot_path) {
+			server.snapshot(snapshot_path, snapshot_interval);
+		}
 		server.listen(host, port);
 	} catch (const std::runtime_error &e) {
 		std::cerr << "Error: " << e.what() << std::endl;
@@ -1,6 +1,7 @@
 #include <mutex>
 #include <atomic>
 #include <condition_variable>
+#include "src/nsemaphore/spin.h"
 
 namespace piex {
 namespace nsemaphore {
@@ -12,12 +13,17 @@ public:
 		terminated_ = true;
 		cv_.notify_one();
 	}
+	/// \returns Counters of the waits that blocked, see `Spinner`
+	Statistics statistics() const {
+		return spinner_.statistics();
+	}
 protected:
 	Base() {}
 	volatile bool terminated_ = false;
 	volatile std::size_t waiting_size_ = 0;
 	std::mutex mutex_;
 	std::condition_variable cv_;
+	Spinner spinner_;
 };
 
 /// \remarks The strict version of nsemaphore with no flush facilities.
@@ -39,12 +45,16 @@ public:
 		}
 	}
 	/// \effects Block until the internal value becomes greater than or equal to `n`
+	/// \remarks Spins before taking the mutex, see `Spinner`
 	void wait(std::size_t n) {
-		if (size_.load() < n && !terminated_) {
-			std::unique_lock<std::mutex> lock(mutex_);
-			waiting_size_ = n;
-			cv_.wait(lock, [this, n]() { return size_.load() >= n || terminated_; });
-			waiting_size_ = 0;
+		auto ready = [this, n]() { return size_.load() >= n || terminated_; };
+		if (!ready()) {
+			spinner_.wait(ready, [&] {
+				std::unique_lock<std::mutex> lock(mutex_);
+				waiting_size_ = n;
+				cv_.wait(lock, ready);
+				waiting_size_ = 0;
+			});
 		}
 	}
 	/// \effects Atomically decrease the internal value by `n`
@@ -86,16 +96,19 @@ public:
 		cv_.notify_one();
 	}
 	/// \effects Block until the internal value becomes greater than or equal to `n` or `flush` is called
+	/// \remarks Spins before taking the mutex, see `Spinner`
 	void wait(std::size_t n) {
-		LooseSize size = size_.load();
-		if (size.size < n && size.flush_size == 0 && !terminated_) {
-			std::unique_lock<std::mutex> lock(mutex_);
-			waiting_size_ = n;
-			cv_.wait(lock, [this, n]() {
-				LooseSize size = size_.load();
-				return size.size >= n || size.flush_size > 0 || terminated_;
+		auto ready = [this, n]() {
+			LooseSize size = size_.load();
+			return size.size >= n || size.flush_size > 0 || terminated_;
+		};
+		if (!ready()) {
+			spinner_.wait(ready, [&] {
+				std::unique_lock<std::mutex> lock(mutex_);
+				waiting_size_ = n;
+				cv_.wait(lock, ready);
+				waiting_size_ = 0;
 			});
-			waiting_size_ = 0;
 		}
 	}
 	/// \effects Atomically decrease the internal value by `n`
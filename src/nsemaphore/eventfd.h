@@ -0,0 +1,177 @@
+#include <unistd.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <stdexcept>
+#include "src/nsemaphore/spin.h"
+
+namespace piex {
+namespace nsemaphore {
+
+/// \remarks Waits sleep on an eventfd rather than a futex, so that the waiting side may instead register `fd()` with epoll or io_uring next to its sockets: `arm` requests a wakeup, the fd becomes readable once it is due, and `disarm` resets it.
+/// \remarks Posts are coalesced: only the post that makes the value reach the requested size writes to the eventfd, and nothing is written while no one waits.
+template <class SizeT>
+class Base {
+public:
+	~Base() {
+		::close(fd_);
+	}
+	/// \effects Wake up waiting threads and make `fd()` readable
+	void terminate() {
+		terminated_.store(true);
+		notify();
+	}
+	/// \returns The eventfd signaled when an armed wait is satisfied
+	int fd() const {
+		return fd_;
+	}
+	/// \effects Stop the wakeup requested by `arm` and make `fd()` unreadable
+	void disarm() {
+		waiting_size_.store(0);
+		std::uint64_t value;
+		while (::read(fd_, &value, sizeof(value)) < 0 && errno == EINTR);
+	}
+	bool terminated() const {
+		return terminated_.load();
+	}
+	/// \returns Counters of the waits that blocked, see `Spinner`
+	Statistics statistics() const {
+		return spinner_.statistics();
+	}
+protected:
+	Base(const SizeT &size) : size_(size) {
+		fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (fd_ < 0) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+	}
+	int fd_ = -1;
+	std::atomic_bool terminated_ = false;
+	std::atomic_size_t waiting_size_ = 0;
+	std::atomic<SizeT> size_;
+	Spinner spinner_;
+
+	void notify() {
+		std::uint64_t one = 1;
+		while (::write(fd_, &one, sizeof(one)) < 0 && errno == EINTR);
+	}
+	/// \effects Wake up the waiter if a post took the value from `before` to `after` across the size it waits for
+	void notify(std::size_t before, std::size_t after) {
+		std::size_t waiting_size = waiting_size_.load();
+		if (before < waiting_size && after >= waiting_size) {
+			notify();
+		}
+	}
+	/// \effects Sleep on `fd()` until `ready` returns true
+	template <class Ready>
+	void park(std::size_t n, const Ready &ready) {
+		// the waiting size is published before the value is checked again and posts update the value before they check the waiting size, so one of the two sides sees the other
+		waiting_size_.store(n);
+		while (!ready()) {
+			pollfd fds = {fd_, POLLIN, 0};
+			::poll(&fds, 1, -1);
+			std::uint64_t value;
+			while (::read(fd_, &value, sizeof(value)) < 0 && errno == EINTR);
+		}
+		waiting_size_.store(0);
+	}
+};
+
+/// \remarks The strict version of nsemaphore with no flush facilities.
+/// \remarks There may only be two threads using it for synchronization. One may only call `load` and `post`. The other may only call `load`, `wait`, `arm`, `disarm` and `consume`.
+class Strict : public Base<std::size_t> {
+public:
+	Strict(std::size_t size) : Base(size) {}
+	/// \returns The internal value held by the nsemaphore
+	std::size_t load() {
+		return size_.load();
+	}
+	/// \effects Atomically increase the internal value by `n`
+	void post(std::size_t n) {
+		std::size_t before = size_.fetch_add(n);
+		notify(before, before + n);
+	}
+	/// \effects Block until the internal value becomes greater than or equal to `n`
+	void wait(std::size_t n) {
+		auto ready = [this, n] { return size_.load() >= n || terminated_.load(); };
+		if (!ready()) {
+			spinner_.wait(ready, [&] { park(n, ready); });
+		}
+	}
+	/// \effects Request `fd()` to become readable once the internal value is greater than or equal to `n`
+	/// \returns Whether it already is, in which case `fd()` may not become readable
+	bool arm(std::size_t n) {
+		waiting_size_.store(n);
+		return size_.load() >= n || terminated_.load();
+	}
+	/// \effects Atomically decrease the internal value by `n`
+	void consume(std::size_t n) {
+		size_ -= n;
+	}
+};
+
+struct LooseSize {
+	// defined as unsigned so that both fit in a lock-free atomic
+	unsigned size_plus_flush_size;
+	unsigned flush_size;
+	unsigned size() const {
+		return size_plus_flush_size - flush_size;
+	}
+};
+
+/// \remarks The loose version of nsemaphore with flush facilities.
+/// \remarks There may only be two threads using it for synchronization. One may only call `load`, `post` and `flush`. The other may only call `load`, `wait`, `arm`, `disarm` and `consume`.
+class Loose : public Base<LooseSize> {
+public:
+	Loose(std::size_t size) : Base({static_cast<unsigned>(size), 0}) {}
+	/// \returns The internal value held by the nsemaphore
+	std::size_t load() {
+		return size_.load().size();
+	}
+	/// \effects Atomically increase the internal value by `n`
+	void post(std::size_t n) {
+		LooseSize size = size_.load();
+		while (!size_.compare_exchange_weak(size, { size.size_plus_flush_size + static_cast<unsigned>(n), size.flush_size }));
+		notify(size.size_plus_flush_size, size.size_plus_flush_size + n);
+	}
+	/// \effects Wake up waiting thread until the current internal value is all consumed
+	void flush() {
+		LooseSize size = size_.load();
+		while (!size_.compare_exchange_weak(size, { size.size() * 2, size.size() }));
+		if (waiting_size_.load()) {
+			notify();
+		}
+	}
+	/// \effects Block until the internal value becomes greater than or equal to `n` or `flush` is called
+	void wait(std::size_t n) {
+		auto ready = [this, n] { return satisfied(n); };
+		if (!ready()) {
+			spinner_.wait(ready, [&] { park(n, ready); });
+		}
+	}
+	/// \effects Request `fd()` to become readable once the internal value is greater than or equal to `n` or `flush` is called
+	/// \returns Whether it already is, in which case `fd()` may not become readable
+	bool arm(std::size_t n) {
+		waiting_size_.store(n);
+		return satisfied(n);
+	}
+	/// \effects Atomically decrease the internal value by `n`
+	void consume(std::size_t n) {
+		LooseSize size = size_.load();
+		while (!size_.compare_exchange_weak(size, {
+			size.size_plus_flush_size - static_cast<unsigned>(n) - (size.flush_size <= n ? size.flush_size : static_cast<unsigned>(n)),
+			size.flush_size <= n ? 0 : size.flush_size - static_cast<unsigned>(n),
+		}));
+	}
+private:
+	bool satisfied(std::size_t n) {
+		LooseSize size = size_.load();
+		return size.size_plus_flush_size >= n || size.flush_size > 0 || terminated_.load();
+	}
+};
+
+}
+}
@@ -1,13 +1,11 @@
-#include <linux/futex.h>
-#include <sys/syscall.h>
 #include <atomic>
+#include "src/nsemaphore/spin.h"
+#include "src/utility/futex.h"
 
 namespace piex {
 namespace nsemaphore {
 
-inline int futex(int *uaddr, int futex_op, int val) {
-    return syscall(SYS_futex, uaddr, futex_op, val, NULL, NULL, 0);
-}
+using utility::futex::futex;
 
 template <class SizeT>
 class Base {
@@ -16,11 +14,15 @@ public:
 		terminated_ = true;
 		futex(reinterpret_cast<int *>(&size_), FUTEX_WAKE_PRIVATE, 1);
 	}
+	Statistics statistics() const {
+		return spinner_.statistics();
+	}
 protected:
 	Base(const SizeT &size) : size_(size) {}
 	volatile bool terminated_ = false;
 	volatile std::size_t waiting_size_ = 0;
 	std::atomic<SizeT> size_;
+	Spinner spinner_;
 };
 
 class Strict : public Base<unsigned> {
@@ -39,12 +41,17 @@ public:
 	void wait(std::size_t n) {
 		unsigned size = size_.load();
 		if (size < n && !terminated_) {
-			waiting_size_ = n;
-			do {
-				futex(reinterpret_cast<int *>(&size_), FUTEX_WAIT_PRIVATE, size);
+			spinner_.wait([&] {
 				size = size_.load();
-			} while (size < n && !terminated_);
-			waiting_size_ = 0;
+				return size >= n || terminated_;
+			}, [&] {
+				waiting_size_ = n;
+				while (size < n && !terminated_) {
+					futex(reinterpret_cast<int *>(&size_), FUTEX_WAIT_PRIVATE, size);
+					size = size_.load();
+				}
+				waiting_size_ = 0;
+			});
 		}
 	}
 	void consume(std::size_t n) {
@@ -83,12 +90,17 @@ public:
 	void wait(std::size_t n) {
 		LooseSize size = size_.load();
 		if (size.size_plus_flush_size < n && size.flush_size == 0 && !terminated_) {
-			waiting_size_ = n;
-			do {
-				futex(reinterpret_cast<int *>(&size_), FUTEX_WAIT_PRIVATE, size.size_plus_flush_size);
+			spinner_.wait([&] {
 				size = size_.load();
-			} while (size.size_plus_flush_size < n && size.flush_size == 0 && !terminated_);
-			waiting_size_ = 0;
+				return size.size_plus_flush_size >= n || size.flush_size > 0 || terminated_;
+			}, [&] {
+				waiting_size_ = n;
+				while (size.size_plus_flush_size < n && size.flush_size == 0 && !terminated_) {
+					futex(reinterpret_cast<int *>(&size_), FUTEX_WAIT_PRIVATE, size.size_plus_flush_size);
+					size = size_.load();
+				}
+				waiting_size_ = 0;
+			});
 		}
 	}
 	void consume(std::size_t n) {
@@ -7,6 +7,8 @@
 	#include "src/nsemaphore/condition_variable.h"
 #elif PIEX_OPTION_NSEMAPHORE == PIEX_OPTION_NSEMAPHORE_FUTEX
 	#include "src/nsemaphore/futex.h"
+#elif PIEX_OPTION_NSEMAPHORE == PIEX_OPTION_NSEMAPHORE_EVENTFD
+	#include "src/nsemaphore/eventfd.h"
 #else
 	#error "Invalid PIEX_OPTION_NSEMAPHORE"
 #endif
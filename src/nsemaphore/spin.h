@@ -0,0 +1,86 @@
+#ifndef PIEX_HEADER_NSEMAPHORE_SPIN
+#define PIEX_HEADER_NSEMAPHORE_SPIN
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <thread>
+#include "src/utility/cpu.h"
+#include "config/config.h"
+
+namespace piex {
+namespace nsemaphore {
+
+#if PIEX_OPTION_NSEMAPHORE_SPINS > 0
+constexpr std::uint32_t MAX_SPINS = PIEX_OPTION_NSEMAPHORE_SPINS;
+constexpr std::chrono::microseconds SPIN_HORIZON(PIEX_OPTION_NSEMAPHORE_SPIN_USEC);
+#else
+constexpr std::uint32_t MAX_SPINS = 0;
+constexpr std::chrono::microseconds SPIN_HORIZON(0);
+#endif
+constexpr std::uint32_t MIN_SPINS = MAX_SPINS < 16 ? MAX_SPINS : 16;
+
+/// \remarks Counters of the waits that had to block, for tuning the spin budget
+struct Statistics {
+	// waits satisfied while spinning
+	std::uint64_t spins;
+	// waits that went to sleep
+	std::uint64_t parks;
+	// the current spin budget
+	std::uint32_t budget;
+};
+
+/// \remarks Waits by spinning with `utility::cpu::relax` before parking the thread. The budget adapts to recent waits: it tracks twice the spins that recent successful spins needed, doubles when a park turns out shorter than `PIEX_OPTION_NSEMAPHORE_SPIN_USEC` and halves when it is longer, between 16 and `PIEX_OPTION_NSEMAPHORE_SPINS` rounds.
+/// \remarks Without `PIEX_OPTION_NSEMAPHORE_SPINS`, or on a single cpu where the other side cannot run while we spin, waits park immediately. Only the waiting thread may call `wait`; `statistics` may be called from any thread.
+class Spinner {
+public:
+	Spinner() : max_(std::thread::hardware_concurrency() > 1 ? MAX_SPINS : 0), budget_(max_) {}
+	/// \effects Spin until `ready` returns true or the budget runs out, then call `park`, which shall block until ready
+	template <class Ready, class Park>
+	void wait(const Ready &ready, const Park &park) {
+		std::uint32_t budget = budget_.load(std::memory_order_relaxed);
+		if (budget == 0) {
+			park();
+			increment(parks_);
+			return;
+		}
+		for (std::uint32_t i = 0; i < budget; ++i) {
+			if (ready()) {
+				// aim at twice the spins needed, as a moving average
+				std::uint32_t target = std::max(2 * i, MIN_SPINS);
+				budget_.store(std::min(budget - budget / 8 + target / 8, max_), std::memory_order_relaxed);
+				increment(spins_);
+				return;
+			}
+			utility::cpu::relax();
+		}
+		auto start = std::chrono::steady_clock::now();
+		park();
+		// a short park means that spinning a little longer would have been cheaper
+		bool short_park = std::chrono::steady_clock::now() - start < SPIN_HORIZON;
+		budget_.store(short_park ? std::min(2 * budget, max_) : std::max(budget / 2, MIN_SPINS), std::memory_order_relaxed);
+		increment(parks_);
+	}
+	Statistics statistics() const {
+		return {
+			spins_.load(std::memory_order_relaxed),
+			parks_.load(std::memory_order_relaxed),
+			budget_.load(std::memory_order_relaxed),
+		};
+	}
+private:
+	const std::uint32_t max_;
+	std::atomic<std::uint32_t> budget_;
+	std::atomic<std::uint64_t> spins_{0}, parks_{0};
+
+	// single writer: no read-modify-write needed
+	static void increment(std::atomic<std::uint64_t> &counter) {
+		counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+};
+
+}
+}
+
+#endif
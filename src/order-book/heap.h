@@ -1,4 +1,6 @@
 #include <deque>
+#include <vector>
+#include <algorithm>
 #include "src/order/order.h"
 #include "src/utility/pool.h"
 
@@ -11,9 +13,9 @@ public:
 	using SizeType = typename std::deque<OrderType>::size_type;
 
 	OrderBook() :
-		pooled_orders_(PIEX_OPTION_ORDER_BOOK_INIT_SIZE / 2),
+		pooled_orders_(PIEX_OPTION_ORDER_BOOK_INIT_SIZE / PIEX_OPTION_ORDER_BOOK_INSTRUMENTS / 2),
 		orders_(pooled_orders_.container()),
-		pooled_order_pos_(PIEX_OPTION_ORDER_BOOK_INIT_SIZE / 2),
+		pooled_order_pos_(PIEX_OPTION_ORDER_BOOK_INIT_SIZE / PIEX_OPTION_ORDER_BOOK_INSTRUMENTS / 2),
 		order_pos_(pooled_order_pos_.container()) {}
 	bool empty() const {
 		return orders_.empty();
@@ -66,6 +68,36 @@ public:
 		}
 		return true;
 	}
+
+	/// \effects Call `f` with every order in the book in priority order
+	/// \complexity O(n log n)
+	template <class F>
+	void for_each(F &&f) const {
+		std::vector<OrderType> sorted(orders_.begin(), orders_.end());
+		std::sort(sorted.begin(), sorted.end());
+		std::for_each(sorted.begin(), sorted.end(), f);
+	}
+
+	/// \effects Call `f` with every order in the book, in no particular order
+	/// \complexity O(n)
+	/// \remarks Allocates no memory
+	template <class F>
+	void for_each_unordered(F &&f) const {
+		std::for_each(orders_.begin(), orders_.end(), f);
+	}
+
+	/// \effects Replace the content of the book with orders in [first, last)
+	/// \requires [first, last) shall be sorted in priority order
+	/// \complexity O(n)
+	/// \remarks A sorted array already satisfies the heap property so no sifting is needed
+	void load(const OrderType *first, const OrderType *last) {
+		orders_.assign(first, last);
+		order_pos_.clear();
+		order_pos_.reserve(orders_.size());
+		for (SizeType i = 0; i < orders_.size(); ++i) {
+			order_pos_.emplace(orders_[i].id(), i);
+		}
+	}
 private:
 	utility::pool::deque<OrderType> pooled_orders_;
 	decltype(pooled_orders_.container()) &orders_;
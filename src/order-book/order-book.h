@@ -3,6 +3,8 @@
 
 #include "config/config.h"
 
+// pooled books start with `PIEX_OPTION_ORDER_BOOK_INIT_SIZE / PIEX_OPTION_ORDER_BOOK_INSTRUMENTS` bytes each and grow on demand, so that the address space reserved follows the instruments actually traded
+
 #if PIEX_OPTION_ORDER_BOOK == PIEX_OPTION_ORDER_BOOK_RBTREE
 	#include "src/order-book/rbtree.h"
 #elif PIEX_OPTION_ORDER_BOOK == PIEX_OPTION_ORDER_BOOK_HEAP
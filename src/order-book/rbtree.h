@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "src/order/order.h"
 #include "src/utility/pool.h"
 
@@ -11,8 +12,8 @@ public:
 	using SizeType = typename std::set<OrderType>::size_type;
 
 	OrderBook() :
-		pooled_orders_(PIEX_OPTION_ORDER_BOOK_INIT_SIZE / 2),
-		pooled_order_prices_(PIEX_OPTION_ORDER_BOOK_INIT_SIZE/ 2) {}
+		pooled_orders_(PIEX_OPTION_ORDER_BOOK_INIT_SIZE / PIEX_OPTION_ORDER_BOOK_INSTRUMENTS / 2),
+		pooled_order_prices_(PIEX_OPTION_ORDER_BOOK_INIT_SIZE / PIEX_OPTION_ORDER_BOOK_INSTRUMENTS / 2) {}
 	bool empty() const {
 		return orders_.empty();
 	}
@@ -53,6 +54,33 @@ public:
 		return true;
 	}
 
+	/// \effects Call `f` with every order in the book in priority order
+	/// \complexity O(n)
+	template <class F>
+	void for_each(F &&f) const {
+		std::for_each(orders_.begin(), orders_.end(), f);
+	}
+
+	/// \effects Call `f` with every order in the book, in no particular order
+	/// \complexity O(n)
+	/// \remarks Allocates no memory
+	template <class F>
+	void for_each_unordered(F &&f) const {
+		for_each(f);
+	}
+
+	/// \effects Replace the content of the book with orders in [first, last)
+	/// \requires [first, last) shall be sorted in priority order
+	/// \complexity O(n)
+	void load(const OrderType *first, const OrderType *last) {
+		orders_.clear();
+		order_prices_.clear();
+		for (const OrderType *it = first; it != last; ++it) {
+			orders_.emplace_hint(orders_.end(), *it);
+			order_prices_.emplace(it->id(), it->price());
+		}
+	}
+
 private:
 	utility::pool::set<OrderType> pooled_orders_;
 	decltype(pooled_orders_.container()) &orders_ = pooled_orders_.container();
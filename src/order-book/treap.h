@@ -1,4 +1,6 @@
 #include <deque>
+#include <vector>
+#include <algorithm>
 #include <boost/intrusive/treap_set.hpp>
 #include "src/order/order.h"
 #include "src/utility/pool.h"
@@ -46,7 +48,7 @@ private:
 public:
 	using SizeType = typename decltype(orders_)::size_type;
 	OrderBook() :
-		allocator_(alignof(Hook<OrderType>) + sizeof(Hook<OrderType>), PIEX_OPTION_ORDER_BOOK_INIT_SIZE),
+		allocator_(alignof(Hook<OrderType>) + sizeof(Hook<OrderType>), PIEX_OPTION_ORDER_BOOK_INIT_SIZE / PIEX_OPTION_ORDER_BOOK_INSTRUMENTS),
 		std_allocator_(allocator_) {}
 	bool empty() const {
 		return orders_.empty();
@@ -88,6 +90,56 @@ public:
 		std_allocator_.deallocate(&data, 1);
 		return true;
 	}
+
+	/// \effects Call `f` with every order in the book in priority order
+	/// \complexity O(n log n)
+	template <class F>
+	void for_each(F &&f) const {
+		std::vector<const OrderType *> sorted;
+		sorted.reserve(orders_.size());
+		for (const auto &hook : orders_) {
+			sorted.push_back(&hook.order());
+		}
+		std::sort(sorted.begin(), sorted.end(), [](const OrderType *a, const OrderType *b) {
+			return *a < *b;
+		});
+		for (const OrderType *order : sorted) {
+			f(*order);
+		}
+	}
+
+	/// \effects Call `f` with every order in the book, in no particular order
+	/// \complexity O(n)
+	/// \remarks Allocates no memory
+	template <class F>
+	void for_each_unordered(F &&f) const {
+		for (const auto &hook : orders_) {
+			f(hook.order());
+		}
+	}
+
+	/// \effects Replace the content of the book with orders in [first, last)
+	/// \requires [first, last) shall be sorted in priority order
+	/// \complexity O(n log n)
+	/// \remarks Nodes are appended in id order so that no search is needed per node
+	void load(const OrderType *first, const OrderType *last) {
+		orders_.clear_and_dispose([this](Hook<OrderType> *data) {
+			std_allocator_.deallocate(data, 1);
+		});
+		std::vector<Hook<OrderType> *> hooks;
+		hooks.reserve(last - first);
+		for (const OrderType *it = first; it != last; ++it) {
+			Hook<OrderType> *ptr = std_allocator_.allocate(1);
+			new(ptr) Hook<OrderType>(*it);
+			hooks.push_back(ptr);
+		}
+		std::sort(hooks.begin(), hooks.end(), [](const Hook<OrderType> *a, const Hook<OrderType> *b) {
+			return *a < *b;
+		});
+		for (Hook<OrderType> *hook : hooks) {
+			orders_.push_back(*hook);
+		}
+	}
 };
 
 }
@@ -1,4 +1,5 @@
 #include <vector>
+#include <iterator>
 #include <algorithm>
 #include "src/order/order.h"
 
@@ -51,6 +52,28 @@ public:
 		return false;
 	}
 
+	/// \effects Call `f` with every order in the book in priority order
+	/// \complexity O(n)
+	template <class F>
+	void for_each(F &&f) const {
+		std::for_each(orders_.rbegin(), orders_.rend(), f);
+	}
+
+	/// \effects Call `f` with every order in the book, in no particular order
+	/// \complexity O(n)
+	/// \remarks Allocates no memory
+	template <class F>
+	void for_each_unordered(F &&f) const {
+		for_each(f);
+	}
+
+	/// \effects Replace the content of the book with orders in [first, last)
+	/// \requires [first, last) shall be sorted in priority order
+	/// \complexity O(n)
+	void load(const OrderType *first, const OrderType *last) {
+		orders_.assign(std::make_reverse_iterator(last), std::make_reverse_iterator(first));
+	}
+
 private:
 	std::vector<OrderType> orders_;
 };
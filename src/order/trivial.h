@@ -6,6 +6,7 @@ public:
 	using IdType = std::uint64_t;
 	using PriceType = std::uint32_t;
 	using QuantityType = std::uint32_t;
+	using InstrumentIdType = std::uint16_t;
 
 	Order(const IdType &id, const PriceType &price, const QuantityType &quantity) :
 		id_(id),
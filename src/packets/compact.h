@@ -1,8 +1,10 @@
+#include <cstddef>
 #include <cstdint>
 #include "src/order/order.h"
 #include "src/utility/bits.h"
 
 // must be little-endian
+// ids are limited to 64 - 3 - INSTRUMENT_BITWIDTH bits since the type flags and the instrument id are packed into them
 
 namespace piex {
 
@@ -37,8 +39,9 @@ public:
 			const OrderType &order_type,
 			const Order::IdType &id,
 			const Order::PriceType &price,
-			const Order::QuantityType &quantity)
-		: order_(construct_id(PLACE, order_type, id), price, quantity) {}
+			const Order::QuantityType &quantity,
+			const Order::InstrumentIdType &instrument = 0)
+		: order_(construct_id(PLACE, order_type, instrument, id), price, quantity) {}
 		Place(const Place &) = default;
 		bool operator== (const Place &other) const {
 			return order_ == other.order_;
@@ -46,6 +49,9 @@ public:
 		OrderType order_type() const {
 			return extract_order_type(order_.id());
 		}
+		Order::InstrumentIdType instrument() const {
+			return extract_instrument(order_.id());
+		}
 		Order order() const {
 			return {
 				extract_id(order_.id()),
@@ -59,8 +65,8 @@ public:
 
 	class Cancel {
 	public:
-		Cancel(const OrderType &order_type, const Order::IdType &id)
-			: id_(construct_id(CANCEL, order_type, id)) {}
+		Cancel(const OrderType &order_type, const Order::IdType &id, const Order::InstrumentIdType &instrument = 0)
+			: id_(construct_id(CANCEL, order_type, instrument, id)) {}
 		Cancel(const Cancel &) = default;
 		bool operator== (const Cancel &other) const {
 			return id_ == other.id_;
@@ -68,6 +74,9 @@ public:
 		OrderType order_type() const {
 			return extract_order_type(id_);
 		}
+		Order::InstrumentIdType instrument() const {
+			return extract_instrument(id_);
+		}
 		Order::IdType id() const {
 			return extract_id(id_);
 		}
@@ -92,12 +101,18 @@ public:
 	Data &data() {
 		return data_;
 	}
+
+	/// \returns The number of bytes a request of `type` takes on the wire
+	static constexpr std::size_t size(Type type) {
+		return type == PLACE ? sizeof(Place) : type == CANCEL ? sizeof(Cancel) : sizeof(Header);
+	}
 private:
 	Data data_;
 	static constexpr std::size_t TYPE_BITWIDTH = 2;
 	static constexpr std::size_t ORDER_TYPE_BITWIDTH = 1;
+	static constexpr std::size_t INSTRUMENT_BITWIDTH = utility::bits::bitwidth<Order::InstrumentIdType>();
 	static Order::IdType extract_id(Order::IdType id) {
-		return utility::bits::discard_bits<TYPE_BITWIDTH + ORDER_TYPE_BITWIDTH>(id);
+		return utility::bits::discard_bits<TYPE_BITWIDTH + ORDER_TYPE_BITWIDTH + INSTRUMENT_BITWIDTH>(id);
 	}
 	static Type extract_type(Order::IdType id) {
 		return static_cast<Type>(utility::bits::extract_bits<TYPE_BITWIDTH>(id));
@@ -105,7 +120,12 @@ private:
 	static OrderType extract_order_type(Order::IdType id) {
 		return static_cast<OrderType>(utility::bits::extract_bits<ORDER_TYPE_BITWIDTH, TYPE_BITWIDTH>(id));
 	}
-	static Order::IdType construct_id(Type type, OrderType order_type, Order::IdType id) {
+	static Order::InstrumentIdType extract_instrument(Order::IdType id) {
+		return static_cast<Order::InstrumentIdType>(utility::bits::extract_bits<INSTRUMENT_BITWIDTH, TYPE_BITWIDTH + ORDER_TYPE_BITWIDTH>(id));
+	}
+	static Order::IdType construct_id(Type type, OrderType order_type, Order::InstrumentIdType instrument, Order::IdType id) {
+		id <<= INSTRUMENT_BITWIDTH;
+		id |= static_cast<Order::IdType>(instrument);
 		id <<= ORDER_TYPE_BITWIDTH;
 		id |= static_cast<Order::IdType>(order_type);
 		id <<= TYPE_BITWIDTH;
@@ -137,8 +157,8 @@ public:
 
 	class Place {
 	public:
-		Place(bool success, const Order::IdType &id)
-			: id_(construct_id(PLACE, success, id)) {}
+		Place(bool success, const Order::IdType &id, const Order::InstrumentIdType &instrument = 0)
+			: id_(construct_id(PLACE, success, instrument, id)) {}
 		Place(const Place &) = default;
 		bool operator== (const Place &other) const {
 			return id_ == other.id_;
@@ -146,6 +166,9 @@ public:
 		bool success() const {
 			return extract_success(id_);
 		}
+		Order::InstrumentIdType instrument() const {
+			return extract_instrument(id_);
+		}
 		Order::IdType id() const {
 			return extract_id(id_);
 		}
@@ -155,8 +178,8 @@ public:
 
 	class Cancel {
 	public:
-		Cancel(bool success, const Order::IdType &id)
-			: id_(construct_id(CANCEL, success, id)) {}
+		Cancel(bool success, const Order::IdType &id, const Order::InstrumentIdType &instrument = 0)
+			: id_(construct_id(CANCEL, success, instrument, id)) {}
 		Cancel(const Cancel &) = default;
 		bool operator== (const Cancel &other) const {
 			return id_ == other.id_;
@@ -164,6 +187,9 @@ public:
 		bool success() const {
 			return extract_success(id_);
 		}
+		Order::InstrumentIdType instrument() const {
+			return extract_instrument(id_);
+		}
 		Order::IdType id() const {
 			return extract_id(id_);
 		}
@@ -179,9 +205,10 @@ public:
 			const Order::PriceType &price,
 			const Order::QuantityType &quantity,
 			const Order::PriceType &top_buy_price,
-			const Order::PriceType &top_sell_price)
+			const Order::PriceType &top_sell_price,
+			const Order::InstrumentIdType &instrument = 0)
 		:
-			buy_id_(construct_id(MATCH, true, buy_id)),
+			buy_id_(construct_id(MATCH, true, instrument, buy_id)),
 			sell_id_(sell_id),
 			price_(price),
 			quantity_(quantity),
@@ -193,15 +220,17 @@ public:
 			const SellOrder &second,
 			const Order::QuantityType &quantity,
 			const Order::PriceType &top_buy_price,
-			const Order::PriceType &top_sell_price)
-		: Match(first.id(), second.id(), first.price(), quantity, top_buy_price, top_sell_price) {}
+			const Order::PriceType &top_sell_price,
+			const Order::InstrumentIdType &instrument = 0)
+		: Match(first.id(), second.id(), first.price(), quantity, top_buy_price, top_sell_price, instrument) {}
 		Match(
 			const SellOrder &first,
 			const BuyOrder &second,
 			const Order::QuantityType &quantity,
 			const Order::PriceType &top_sell_price,
-			const Order::PriceType &top_buy_price)
-		: Match(second.id(), first.id(), first.price(), quantity, top_buy_price, top_sell_price) {}
+			const Order::PriceType &top_buy_price,
+			const Order::InstrumentIdType &instrument = 0)
+		: Match(second.id(), first.id(), first.price(), quantity, top_buy_price, top_sell_price, instrument) {}
 		Match(const Match &) = default;
 		bool operator== (const Match &other) const {
 			return buy_id_ == other.buy_id_
@@ -211,6 +240,9 @@ public:
 				&& top_buy_price_ == other.top_buy_price_
 				&& top_sell_price_ == other.top_sell_price_;
 		}
+		Order::InstrumentIdType instrument() const {
+			return extract_instrument(buy_id_);
+		}
 		Order::IdType buy_id() const {
 			return extract_id(buy_id_);
 		}
@@ -251,8 +283,9 @@ private:
 	Data data_;
 	static constexpr std::size_t TYPE_BITWIDTH = 2;
 	static constexpr std::size_t SUCCESS_BITWIDTH = 1;
+	static constexpr std::size_t INSTRUMENT_BITWIDTH = utility::bits::bitwidth<Order::InstrumentIdType>();
 	static Order::IdType extract_id(Order::IdType id) {
-		return utility::bits::discard_bits<TYPE_BITWIDTH + SUCCESS_BITWIDTH>(id);
+		return utility::bits::discard_bits<TYPE_BITWIDTH + SUCCESS_BITWIDTH + INSTRUMENT_BITWIDTH>(id);
 	}
 	static Type extract_type(Order::IdType id) {
 		return static_cast<Type>(utility::bits::extract_bits<TYPE_BITWIDTH>(id));
@@ -260,7 +293,12 @@ private:
 	static bool extract_success(Order::IdType id) {
 		return static_cast<bool>(utility::bits::extract_bits<SUCCESS_BITWIDTH, TYPE_BITWIDTH>(id));
 	}
-	static Order::IdType construct_id(Type type, bool success, Order::IdType id) {
+	static Order::InstrumentIdType extract_instrument(Order::IdType id) {
+		return static_cast<Order::InstrumentIdType>(utility::bits::extract_bits<INSTRUMENT_BITWIDTH, TYPE_BITWIDTH + SUCCESS_BITWIDTH>(id));
+	}
+	static Order::IdType construct_id(Type type, bool success, Order::InstrumentIdType instrument, Order::IdType id) {
+		id <<= INSTRUMENT_BITWIDTH;
+		id |= static_cast<Order::IdType>(instrument);
 		id <<= SUCCESS_BITWIDTH;
 		id |= static_cast<Order::IdType>(success);
 		id <<= TYPE_BITWIDTH;
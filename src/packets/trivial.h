@@ -1,3 +1,4 @@
+#include <cstddef>
 #include <cstdint>
 #include "src/order/order.h"
 
@@ -34,44 +35,55 @@ public:
 			const OrderType &order_type,
 			const Order::IdType &id,
 			const Order::PriceType &price,
-			const Order::QuantityType &quantity)
-		: header_(PLACE), order_type_(order_type), order_(id, price, quantity) {}
+			const Order::QuantityType &quantity,
+			const Order::InstrumentIdType &instrument = 0)
+		: header_(PLACE), order_type_(order_type), instrument_(instrument), order_(id, price, quantity) {}
 		Place(const Place &) = default;
 		bool operator== (const Place &other) const {
 			return order_type_ == other.order_type_
+				&& instrument_ == other.instrument_
 				&& order_ == other.order_;
 		}
 		const OrderType &order_type() const {
 			return order_type_;
 		}
+		const Order::InstrumentIdType &instrument() const {
+			return instrument_;
+		}
 		const Order &order() const {
 			return order_;
 		}
 	private:
 		Header header_;
 		OrderType order_type_;
+		Order::InstrumentIdType instrument_;
 		Order order_;
 	};
 
 	class Cancel {
 	public:
-		Cancel(const OrderType &order_type, const Order::IdType &id) :
-			header_(CANCEL), order_type_(order_type), id_(id) {
+		Cancel(const OrderType &order_type, const Order::IdType &id, const Order::InstrumentIdType &instrument = 0) :
+			header_(CANCEL), order_type_(order_type), instrument_(instrument), id_(id) {
 		}
 		Cancel(const Cancel &) = default;
 		bool operator== (const Cancel &other) const {
 			return order_type_ == other.order_type_
+				&& instrument_ == other.instrument_
 				&& id_ == other.id_;
 		}
 		const OrderType &order_type() const {
 			return order_type_;
 		}
+		const Order::InstrumentIdType &instrument() const {
+			return instrument_;
+		}
 		const Order::IdType &id() const {
 			return id_;
 		}
 	private:
 		Header header_;
 		OrderType order_type_;
+		Order::InstrumentIdType instrument_;
 		Order::IdType id_;
 	};
 
@@ -92,6 +104,11 @@ public:
 	Data &data() {
 		return data_;
 	}
+
+	/// \returns The number of bytes a request of `type` takes on the wire
+	static constexpr std::size_t size(Type type) {
+		return type == PLACE ? sizeof(Place) : type == CANCEL ? sizeof(Cancel) : sizeof(Header);
+	}
 private:
 	Data data_;
 };
@@ -119,49 +136,61 @@ public:
 
 	class Place {
 	public:
-		Place(bool success, const Order::IdType &id) :
+		Place(bool success, const Order::IdType &id, const Order::InstrumentIdType &instrument = 0) :
 			header_(PLACE),
 			success_(success),
+			instrument_(instrument),
 			id_(id) {
 		}
 		Place(const Place &) = default;
 		bool operator== (const Place &other) const {
 			return success_ == other.success_
+				&& instrument_ == other.instrument_
 				&& id_ == other.id_;
 		}
 		bool success() const {
 			return success_;
 		}
+		const Order::InstrumentIdType &instrument() const {
+			return instrument_;
+		}
 		const Order::IdType &id() const {
 			return id_;
 		}
 	private:
 		Header header_;
 		bool success_;
+		Order::InstrumentIdType instrument_;
 		Order::IdType id_;
 	};
 
 	class Cancel {
 	public:
-		Cancel(bool success, const Order::IdType &id) :
+		Cancel(bool success, const Order::IdType &id, const Order::InstrumentIdType &instrument = 0) :
 			header_(CANCEL),
 			success_(success),
+			instrument_(instrument),
 			id_(id) {
 		}
 		Cancel(const Cancel &) = default;
 		bool operator== (const Cancel &other) const {
 			return success_ == other.success_
+				&& instrument_ == other.instrument_
 				&& id_ == other.id_;
 		}
 		bool success() const {
 			return success_;
 		}
+		const Order::InstrumentIdType &instrument() const {
+			return instrument_;
+		}
 		const Order::IdType &id() const {
 			return id_;
 		}
 	private:
 		Header header_;
 		bool success_;
+		Order::InstrumentIdType instrument_;
 		Order::IdType id_;
 	};
 
@@ -173,9 +202,11 @@ public:
 			const Order::PriceType &price,
 			const Order::QuantityType &quantity,
 			const Order::PriceType &top_buy_price,
-			const Order::PriceType &top_sell_price)
+			const Order::PriceType &top_sell_price,
+			const Order::InstrumentIdType &instrument = 0)
 		:
 			header_(MATCH),
+			instrument_(instrument),
 			buy_id_(buy_id),
 			sell_id_(sell_id),
 			price_(price),
@@ -188,24 +219,30 @@ public:
 			const SellOrder &second,
 			const Order::QuantityType &quantity,
 			const Order::PriceType &top_buy_price,
-			const Order::PriceType &top_sell_price)
-		: Match(first.id(), second.id(), first.price(), quantity, top_buy_price, top_sell_price) {}
+			const Order::PriceType &top_sell_price,
+			const Order::InstrumentIdType &instrument = 0)
+		: Match(first.id(), second.id(), first.price(), quantity, top_buy_price, top_sell_price, instrument) {}
 		Match(
 			const SellOrder &first,
 			const BuyOrder &second,
 			const Order::QuantityType &quantity,
 			const Order::PriceType &top_sell_price,
-			const Order::PriceType &top_buy_price)
-		: Match(second.id(), first.id(), first.price(), quantity, top_buy_price, top_sell_price) {}
+			const Order::PriceType &top_buy_price,
+			const Order::InstrumentIdType &instrument = 0)
+		: Match(second.id(), first.id(), first.price(), quantity, top_buy_price, top_sell_price, instrument) {}
 		Match(const Match &) = default;
 		bool operator== (const Match &other) const {
-			return buy_id_ == other.buy_id_
+			return instrument_ == other.instrument_
+				&& buy_id_ == other.buy_id_
 				&& sell_id_ == other.sell_id_
 				&& price_ == other.price_
 				&& quantity_ == other.quantity_
 				&& top_buy_price_ == other.top_buy_price_
 				&& top_sell_price_ == other.top_sell_price_;
 		}
+		const Order::InstrumentIdType &instrument() const {
+			return instrument_;
+		}
 		const Order::IdType &buy_id() const {
 			return buy_id_;
 		}
@@ -226,6 +263,7 @@ public:
 		}
 	private:
 		Header header_;
+		Order::InstrumentIdType instrument_;
 		Order::IdType buy_id_, sell_id_;
 		Order::PriceType price_;
 		Order::QuantityType quantity_;
@@ -0,0 +1,348 @@
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netdb.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include "src/exchange/market.h"
+#include "src/packets/packets.h"
+#include "src/order/order.h"
+#include "src/snapshot/snapshot.h"
+#include "src/utility/socket.h"
+#include "src/utility/thread.h"
+#include "config/config.h"
+
+namespace piex {
+namespace server {
+
+/// \remarks A client session. Requests are decoded from `in`; responses are queued in `out` and written when the socket accepts them
+struct Connection {
+	std::uint64_t id;
+	int fd;
+	std::uint8_t in[PIEX_OPTION_SERVER_EPOLL_BUFFER_SIZE];
+	std::size_t in_size = 0;
+	std::vector<std::uint8_t> out;
+	std::size_t out_offset = 0;
+	std::uint32_t events = EPOLLIN;
+	bool dirty = false;
+};
+
+/// \remarks Identifies a resting order
+struct OrderKey {
+	Order::IdType id;
+	Order::InstrumentIdType instrument;
+	bool buy;
+	bool operator== (const OrderKey &other) const {
+		return id == other.id && instrument == other.instrument && buy == other.buy;
+	}
+};
+
+struct OrderKeyHash {
+	std::size_t operator() (const OrderKey &key) const {
+		return std::hash<Order::IdType>()(key.id) ^ (static_cast<std::size_t>(key.instrument) << 1 | key.buy) * 0x9e3779b97f4a7c15ULL;
+	}
+};
+
+/// \remarks The connection that placed a resting order and the quantity left in the book
+struct Owner {
+	std::uint64_t connection;
+	Order::QuantityType quantity;
+};
+
+/// \remarks Serves many clients from a single thread. Sockets are non-blocking and multiplexed with epoll. Responses of a request go to the connection that sent it, and every match is also sent to the owner of the resting order.
+/// \remarks Order ids shall be unique per instrument and side across all clients. Only the owner of an order may cancel it. Orders stay in the books when their owner disconnects, like orders restored from a snapshot they have no owner: matches against them are dropped and any client may cancel them.
+class Server {
+public:
+	Server() : market_(*this) {
+		epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+		if (epoll_fd_ < 0) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+	}
+	Server(const Server &) = delete;
+	~Server() {
+		for (auto &connection : connections_) {
+			::close(connection.second->fd);
+		}
+		if (listen_fd_ != -1) {
+			::close(listen_fd_);
+		}
+		::close(epoll_fd_);
+	}
+
+	/// \effects Restore the order books from `path` if it exists and take a snapshot into it every `interval` requests
+	/// \param path The snapshot file
+	/// \param interval The number of requests between two snapshots
+	/// \remarks Restored orders have no owner
+	void snapshot(const char *path, std::uint64_t interval) {
+		if (::access(path, F_OK) == 0) {
+			market_.restore(path);
+		}
+		snapshotter_.enable(path, interval, market_.sequence());
+	}
+
+	/// \effects Listen on specified host and port
+	/// \param host The host to listen at
+	/// \param port The port to listen at
+	/// \remarks The behavior is undefined if clients send invalid data. The calling thread is placed as the matching thread of `utility::thread::affinity()`
+	void listen(const char *host, const char *port) {
+		utility::thread::place(pthread_self(), utility::thread::affinity().matching);
+		listen_fd_ = utility::socket::create_socket(host, port, true);
+		if (::listen(listen_fd_, SOMAXCONN) < 0) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+		utility::socket::set_nonblocking(listen_fd_);
+		control(EPOLL_CTL_ADD, listen_fd_, EPOLLIN, LISTENER);
+		epoll_event events[PIEX_OPTION_SERVER_EPOLL_EVENTS];
+		while (true) {
+			int n = ::epoll_wait(epoll_fd_, events, PIEX_OPTION_SERVER_EPOLL_EVENTS, -1);
+			if (n < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				throw std::runtime_error(std::strerror(errno));
+			}
+			for (int i = 0; i < n; ++i) {
+				if (events[i].data.u64 == LISTENER) {
+					accept();
+					continue;
+				}
+				auto it = connections_.find(events[i].data.u64);
+				if (it == connections_.end()) {
+					continue;
+				}
+				Connection &connection = *it->second;
+				bool alive = true;
+				if (events[i].events & EPOLLOUT) {
+					alive = write(connection);
+				}
+				if (alive && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+					alive = read(connection);
+				}
+				if (!alive) {
+					close(connection);
+				}
+			}
+			flush();
+		}
+	}
+
+	/// \returns The number of connected clients
+	std::size_t connections() const {
+		return connections_.size();
+	}
+
+	void on_place(const Response::Place &response) {
+		if (response.success() && remaining_ > 0) {
+			owners_[{response.id(), response.instrument(), buy_}] = {current_->id, remaining_};
+		}
+		send(*current_, response);
+	}
+	void on_cancel(const Response::Cancel &response) {
+		if (response.success()) {
+			owners_.erase({response.id(), response.instrument(), buy_});
+		}
+		send(*current_, response);
+	}
+	void on_match(const Response::Match &response) {
+		remaining_ -= response.quantity();
+		send(*current_, response);
+		auto it = owners_.find({buy_ ? response.sell_id() : response.buy_id(), response.instrument(), !buy_});
+		if (it == owners_.end()) {
+			return;
+		}
+		auto connection = connections_.find(it->second.connection);
+		if (connection != connections_.end() && connection->second.get() != current_) {
+			send(*connection->second, response);
+		}
+		it->second.quantity -= response.quantity();
+		if (it->second.quantity == 0) {
+			owners_.erase(it);
+		}
+	}
+private:
+	static constexpr std::uint64_t LISTENER = 0;
+	Market<Server> market_;
+	snapshot::Scheduler snapshotter_;
+	int epoll_fd_ = -1;
+	int listen_fd_ = -1;
+	std::uint64_t next_id_ = LISTENER + 1;
+	std::unordered_map<std::uint64_t, std::unique_ptr<Connection>> connections_;
+	std::vector<std::uint64_t> dirty_;
+	std::unordered_map<OrderKey, Owner, OrderKeyHash> owners_;
+	// the request being processed
+	Connection *current_ = nullptr;
+	bool buy_ = false;
+	Order::QuantityType remaining_ = 0;
+
+	void control(int op, int fd, std::uint32_t events, std::uint64_t id) {
+		epoll_event event = {};
+		event.events = events;
+		event.data.u64 = id;
+		if (::epoll_ctl(epoll_fd_, op, fd, &event) < 0) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+	}
+
+	/// \effects Accept all pending connections
+	void accept() {
+		while (true) {
+			int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+			if (fd < 0) {
+				if (errno == EINTR || errno == ECONNABORTED) {
+					continue;
+				}
+				if (errno == EAGAIN || errno == EWOULDBLOCK) {
+					return;
+				}
+				throw std::runtime_error(std::strerror(errno));
+			}
+			auto connection = std::make_unique<Connection>();
+			connection->id = next_id_++;
+			connection->fd = fd;
+			control(EPOLL_CTL_ADD, fd, connection->events, connection->id);
+			connections_.emplace(connection->id, std::move(connection));
+		}
+	}
+
+	void close(Connection &connection) {
+		// orders of the connection are left without owner; disconnects are rare enough to scan all orders
+		for (auto it = owners_.begin(); it != owners_.end();) {
+			it = it->second.connection == connection.id ? owners_.erase(it) : std::next(it);
+		}
+		::close(connection.fd);
+		connections_.erase(connection.id);
+	}
+
+	/// \returns false if the order to cancel is owned by another connection
+	bool owns(const Connection &connection, const Request::Cancel &request) const {
+		auto it = owners_.find({request.id(), request.instrument(), buy_});
+		return it == owners_.end() || it->second.connection == connection.id;
+	}
+
+	/// \effects Read available data from `connection` and process all complete requests
+	/// \returns false if the connection is closed
+	bool read(Connection &connection) {
+		ssize_t ret = ::read(connection.fd, connection.in + connection.in_size, sizeof(connection.in) - connection.in_size);
+		if (ret < 0) {
+			return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+		}
+		if (ret == 0) {
+			return false;
+		}
+		connection.in_size += ret;
+		std::size_t offset = 0;
+		current_ = &connection;
+		while (connection.in_size - offset >= sizeof(Request::Header)) {
+			const std::uint8_t *data = connection.in + offset;
+			std::size_t size = Request::size(reinterpret_cast<const Request::Header *>(data)->type());
+			if (connection.in_size - offset < size) {
+				break;
+			}
+			offset += size;
+			// decoded in place from the input buffer
+			const Request::Data &request = *reinterpret_cast<const Request::Data *>(data);
+			switch (request.header.type()) {
+			case Request::PLACE:
+				buy_ = request.place.order_type() == Request::BUY;
+				remaining_ = request.place.order().quantity();
+				market_.process_request(request.place);
+				snapshotter_.poll(market_);
+				break;
+			case Request::CANCEL:
+				buy_ = request.cancel.order_type() == Request::BUY;
+				if (!owns(connection, request.cancel)) {
+					send(connection, Response::Cancel(false, request.cancel.id(), request.cancel.instrument()));
+					break;
+				}
+				market_.process_request(request.cancel);
+				snapshotter_.poll(market_);
+				break;
+			case Request::FLUSH:
+				// responses are written at the end of every batch of events
+				break;
+			}
+		}
+		current_ = nullptr;
+		connection.in_size -= offset;
+		std::memmove(connection.in, connection.in + offset, connection.in_size);
+		return true;
+	}
+
+	/// \effects Queue a response to `connection`
+	template <class R>
+	void send(Connection &connection, const R &response) {
+		const std::uint8_t *data = reinterpret_cast<const std::uint8_t *>(&response);
+		connection.out.insert(connection.out.end(), data, data + sizeof(response));
+		if (!connection.dirty) {
+			connection.dirty = true;
+			dirty_.push_back(connection.id);
+		}
+	}
+
+	/// \effects Write queued responses of `connection` until the socket would block
+	/// \returns false if the connection is broken
+	bool write(Connection &connection) {
+		while (connection.out_offset < connection.out.size()) {
+			ssize_t ret = ::send(
+				connection.fd,
+				connection.out.data() + connection.out_offset,
+				connection.out.size() - connection.out_offset,
+				MSG_NOSIGNAL);
+			if (ret < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				if (errno == EAGAIN || errno == EWOULDBLOCK) {
+					break;
+				}
+				return false;
+			}
+			connection.out_offset += ret;
+		}
+		if (connection.out_offset == connection.out.size()) {
+			connection.out.clear();
+			connection.out_offset = 0;
+		}
+		// stop reading from clients that do not read their responses
+		std::uint32_t events = connection.out.empty() ? EPOLLIN : EPOLLOUT;
+		if (connection.out.size() - connection.out_offset < PIEX_OPTION_SERVER_EPOLL_BUFFER_SIZE) {
+			events |= EPOLLIN;
+		}
+		if (events != connection.events) {
+			connection.events = events;
+			control(EPOLL_CTL_MOD, connection.fd, events, connection.id);
+		}
+		return true;
+	}
+
+	/// \effects Write queued responses of all connections touched in the current batch of events
+	void flush() {
+		for (std::uint64_t id : dirty_) {
+			auto it = connections_.find(id);
+			if (it == connections_.end()) {
+				continue;
+			}
+			Connection &connection = *it->second;
+			connection.dirty = false;
+			if (!write(connection)) {
+				close(connection);
+			}
+		}
+		dirty_.clear();
+	}
+};
+
+}
+
+using server::Server;
+
+}
@@ -0,0 +1,54 @@
+#ifndef PIEX_HEADER_SERVER_FLUSH
+#define PIEX_HEADER_SERVER_FLUSH
+
+#include <cstdint>
+#include <chrono>
+#include "config/config.h"
+
+namespace piex {
+namespace server {
+
+/// \remarks Decides when responses are flushed without a flush request from the client: as soon as no more input is readable, so that responses are batched under load and sent at once when idle, or when the oldest unflushed response is `PIEX_OPTION_SERVER_FLUSH_DEADLINE_USEC` old, so that a client streaming requests without pause still gets responses. A deadline of 0 disables the latter.
+/// \remarks Enabled with `PIEX_OPTION_SERVER_IMPLICIT_FLUSH`; explicit flush requests are honored either way
+class Flusher {
+public:
+	/// \effects Record that a request has been processed and its responses written
+	void processed() {
+#if PIEX_OPTION_SERVER_FLUSH_DEADLINE_USEC > 0
+		if (!pending_) {
+			since_ = std::chrono::steady_clock::now();
+		}
+#endif
+		pending_ = true;
+	}
+	/// \effects Record that responses have been flushed
+	void flushed() {
+		pending_ = false;
+	}
+	/// \returns Whether written responses shall be flushed now
+	/// \param socket The socket requests are read from
+	template <class Socket>
+	bool due(Socket &socket) {
+		if (!pending_) {
+			return false;
+		}
+		if (!socket.read_ready()) {
+			return true;
+		}
+#if PIEX_OPTION_SERVER_FLUSH_DEADLINE_USEC > 0
+		return std::chrono::steady_clock::now() - since_ >= std::chrono::microseconds(PIEX_OPTION_SERVER_FLUSH_DEADLINE_USEC);
+#else
+		return false;
+#endif
+	}
+private:
+	bool pending_ = false;
+#if PIEX_OPTION_SERVER_FLUSH_DEADLINE_USEC > 0
+	std::chrono::steady_clock::time_point since_;
+#endif
+};
+
+}
+}
+
+#endif
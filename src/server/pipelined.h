@@ -0,0 +1,392 @@
+#include <unistd.h>
+#include <linux/futex.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <memory>
+#include <vector>
+#include <array>
+#include <atomic>
+#include <thread>
+#include "src/exchange/market.h"
+#include "src/packets/packets.h"
+#include "src/socket/socket.h"
+#include "src/snapshot/snapshot.h"
+#include "src/server/flush.h"
+#include "src/utility/spsc.h"
+#include "src/utility/futex.h"
+#include "src/utility/thread.h"
+#include "config/config.h"
+
+namespace piex {
+namespace server {
+
+/// \remarks Entry of the request and response rings. A slot carries one packet.
+template <class Packet>
+struct Slot {
+	alignas(Packet) std::uint8_t data[sizeof(Packet)];
+	Packet &packet() {
+		return *reinterpret_cast<Packet *>(data);
+	}
+};
+
+/// \remarks Tells the writer thread which shard holds the responses of the next request, or carries a control message
+struct Route {
+	enum Control : std::uint8_t {
+		SHARD,
+		FLUSH,
+		CLOSE,
+	};
+	Control control;
+	std::uint16_t shard;
+};
+
+struct QueueDepth {
+	std::size_t requests;
+	std::size_t responses;
+	std::size_t max_requests;
+	std::size_t max_responses;
+};
+
+using RequestSlot = Slot<Request>;
+using ResponseSlot = Slot<Response>;
+
+#if PIEX_OPTION_SERVER_SPINS > 0
+constexpr std::uint32_t SPINS = PIEX_OPTION_SERVER_SPINS;
+#else
+constexpr std::uint32_t SPINS = 0;
+#endif
+
+/// \returns A free slot of `ring`, waiting until one is available, or nullptr once `terminated` is set
+/// \remarks Spins for `PIEX_OPTION_SERVER_SPINS` rounds before sleeping
+template <class Ring>
+typename Ring::ValueType *reserve(Ring &ring, const std::atomic_bool &terminated) {
+	return ring.wait_reserve(SPINS, terminated);
+}
+
+/// \effects Publish the reserved slot of `ring` and record the queue depth
+template <class Ring>
+void publish(Ring &ring, std::atomic_size_t &max_depth) {
+	ring.publish();
+	std::size_t depth = ring.size();
+	if (depth > max_depth.load(std::memory_order_relaxed)) {
+		max_depth.store(depth, std::memory_order_relaxed);
+	}
+}
+
+/// \returns The slot at the head of `ring`, waiting until one is published, or nullptr once `terminated` is set
+/// \remarks Spins for `PIEX_OPTION_SERVER_SPINS` rounds before sleeping
+template <class Ring>
+typename Ring::ValueType *front(Ring &ring, const std::atomic_bool &terminated) {
+	return ring.wait_front(SPINS, terminated);
+}
+
+/// \remarks A matching thread owning the exchanges of a subset of instruments. Shards share no mutable state with each other.
+class Shard {
+public:
+	using RequestRing = utility::spsc::Ring<RequestSlot, PIEX_OPTION_SERVER_QUEUE_SIZE>;
+	using ResponseRing = utility::spsc::Ring<ResponseSlot, PIEX_OPTION_SERVER_QUEUE_SIZE>;
+
+	Shard(const utility::thread::Placement &placement, const std::atomic_bool &terminated) :
+		market_(*this),
+		terminated_(terminated),
+		thread_(utility::thread::spawn(placement, &Shard::body, this)) {}
+	~Shard() {
+		thread_.join();
+	}
+
+	/// \effects Restore the order books from `path` if it exists and take a snapshot into it every `interval` requests
+	void snapshot(const char *path, std::uint64_t interval) {
+		if (::access(path, F_OK) == 0) {
+			market_.restore(path);
+		}
+		snapshotter_.enable(path, interval, market_.sequence());
+	}
+
+	QueueDepth queue_depth() const {
+		return {
+			requests_.size(),
+			responses_.size(),
+			max_requests_.load(std::memory_order_relaxed),
+			max_responses_.load(std::memory_order_relaxed),
+		};
+	}
+
+	void on_place(const Response::Place &response) {
+		push_response(response);
+	}
+	void on_cancel(const Response::Cancel &response) {
+		push_response(response);
+	}
+	void on_match(const Response::Match &response) {
+		push_response(response);
+	}
+
+	RequestRing requests_;
+	ResponseRing responses_;
+	std::atomic_size_t max_requests_ = 0, max_responses_ = 0;
+private:
+	Market<Shard> market_;
+	snapshot::Scheduler snapshotter_;
+	const std::atomic_bool &terminated_;
+	std::thread thread_;
+
+	template <class R>
+	void push_response(const R &response) {
+		ResponseSlot *slot = reserve(responses_, terminated_);
+		if (!slot) {
+			return;
+		}
+		std::memcpy(slot->data, &response, sizeof(response));
+		publish(responses_, max_responses_);
+	}
+
+	void body() {
+		while (RequestSlot *slot = front(requests_, terminated_)) {
+			Request::Data &data = slot->packet().data();
+			// the network thread routes places and cancels only
+			if (data.header.type() == Request::PLACE) {
+				market_.process_request(data.place);
+			} else {
+				market_.process_request(data.cancel);
+			}
+			requests_.pop();
+			snapshotter_.poll(market_);
+		}
+	}
+};
+
+/// \remarks The network thread (the caller of `listen`) decodes requests and routes each one to the shard owning its instrument. Every shard runs its exchanges on a dedicated matching thread. The writer thread follows the routing order to merge the responses of all shards back into request order and serializes them to the socket.
+class Server {
+public:
+	static constexpr std::size_t SHARDS = PIEX_OPTION_SERVER_SHARDS;
+
+	/// \remarks The network, matching and writer threads are placed as the reader, matching and writer of `utility::thread::affinity()`, which take precedence over the compile-time cpus. Shards after the first run on the next online cpus not taken by the network and writer threads. Throws before any thread starts if they do not fit
+	Server() :
+		routes_(std::make_unique<RouteRing>()),
+		network_(placement(utility::thread::affinity().reader, PIEX_OPTION_SERVER_NETWORK_CPU)) {
+		utility::thread::Placement writer = placement(utility::thread::affinity().writer, PIEX_OPTION_SERVER_WRITER_CPU);
+		std::vector<int> taken;
+		for (int cpu : {network_.cpu, writer.cpu}) {
+			if (cpu >= 0) {
+				taken.push_back(cpu);
+			}
+		}
+		std::vector<utility::thread::Placement> shards = utility::thread::spread(
+			placement(utility::thread::affinity().matching, PIEX_OPTION_SERVER_MATCHING_CPU),
+			SHARDS,
+			taken,
+			utility::thread::topology());
+		try {
+			for (std::size_t i = 0; i < SHARDS; ++i) {
+				shards_[i] = std::make_unique<Shard>(shards[i], terminated_);
+			}
+			writer_thread_ = utility::thread::spawn(writer, &Server::writer_body, this);
+		} catch (...) {
+			// shards already started only return once terminated, and are joined on destruction
+			terminate();
+			for (auto &shard : shards_) {
+				shard.reset();
+			}
+			throw;
+		}
+	}
+	~Server() {
+		terminate();
+		writer_thread_.join();
+		for (auto &shard : shards_) {
+			shard.reset();
+		}
+	}
+
+	/// \effects Restore the order books from `path` if it exists and take a snapshot into it every `interval` requests
+	/// \param path The snapshot file. With more than one shard, shard `i` uses `path.i`
+	/// \param interval The number of requests of a shard between two snapshots
+	/// \remarks Shall be called before `listen`
+	void snapshot(const char *path, std::uint64_t interval) {
+		for (std::size_t i = 0; i < SHARDS; ++i) {
+			shard_paths_[i] = SHARDS > 1 ? std::string(path) + "." + std::to_string(i) : std::string(path);
+			shards_[i]->snapshot(shard_paths_[i].c_str(), interval);
+		}
+	}
+
+	/// \effects Listen on specified host and port
+	/// \param host The host to listen at
+	/// \param port The port to listen at
+	/// \remarks The behavior is undefined if clients send invalid data
+	void listen(const char *host, const char *port) {
+		utility::thread::place(pthread_self(), network_);
+		sck_listen.listen(host, port);
+		while (true) {
+			socket = std::make_unique<Socket>(sck_listen.accept());
+			while (const void *header = socket->peek(sizeof(Request::Header))) {
+				std::size_t size = Request::size(static_cast<const Request::Header *>(header)->type());
+				const void *data = socket->peek(size);
+				if (!data) {
+					break;
+				}
+				// decoded in place from the socket buffer and copied once into the shard queue
+				const Request::Data &request = *static_cast<const Request::Data *>(data);
+				switch (request.header.type()) {
+				case Request::PLACE:
+					route(request.place);
+					flusher_.processed();
+					break;
+				case Request::CANCEL:
+					route(request.cancel);
+					flusher_.processed();
+					break;
+				case Request::FLUSH:
+					push_route(Route::FLUSH);
+					flusher_.flushed();
+					break;
+				}
+				socket->consume(size);
+#if PIEX_OPTION_SERVER_IMPLICIT_FLUSH
+				// the writer thread flushes once it has written the responses of the requests before
+				if (flusher_.due(*socket)) {
+					push_route(Route::FLUSH);
+					flusher_.flushed();
+				}
+#endif
+			}
+			closed_ = 0;
+			push_route(Route::CLOSE);
+			// the writer thread wakes us up once it has flushed the responses to the connection
+			while (!closed_) {
+				utility::futex::futex(&closed_, FUTEX_WAIT_PRIVATE, 0);
+			}
+		}
+	}
+
+	/// \returns The current and the maximum observed number of entries between the stages of `shard`
+	QueueDepth queue_depth(std::size_t shard = 0) const {
+		return shards_[shard]->queue_depth();
+	}
+
+	/// \returns The number of requests routed but not yet answered
+	std::size_t route_depth() const {
+		return routes_->size();
+	}
+
+	/// \returns The shard owning `instrument`
+	static std::size_t shard_of(Order::InstrumentIdType instrument) {
+		return instrument % SHARDS;
+	}
+private:
+	using RouteRing = utility::spsc::Ring<Route, PIEX_OPTION_SERVER_QUEUE_SIZE * PIEX_OPTION_SERVER_SHARDS>;
+
+	std::array<std::unique_ptr<Shard>, SHARDS> shards_;
+	std::array<std::string, SHARDS> shard_paths_;
+	Socket sck_listen;
+	std::unique_ptr<Socket> socket;
+	server::Flusher flusher_;
+	std::unique_ptr<RouteRing> routes_;
+	std::atomic_size_t max_routes_ = 0;
+	std::atomic<std::uint32_t> closed_ = 0;
+	std::atomic_bool terminated_ = false;
+	const utility::thread::Placement network_;
+	std::thread writer_thread_;
+
+	// `configured`, or the compile-time `cpu` if it leaves the cpu to the scheduler
+	static utility::thread::Placement placement(utility::thread::Placement configured, int cpu) {
+		if (configured.cpu < 0) {
+			configured.cpu = cpu;
+		}
+		return configured;
+	}
+
+	// wake up the threads waiting on the rings, which return once terminated
+	void terminate() {
+		terminated_ = true;
+		routes_->interrupt();
+		for (auto &shard : shards_) {
+			if (shard) {
+				shard->requests_.interrupt();
+				shard->responses_.interrupt();
+			}
+		}
+	}
+
+	/// \effects Hand a request to the shard owning its instrument and record the routing for the writer thread
+	template <class R>
+	void route(const R &request) {
+		std::size_t shard = shard_of(request.instrument());
+		Shard &target = *shards_[shard];
+		RequestSlot *slot = reserve(target.requests_, terminated_);
+		if (!slot) {
+			return;
+		}
+		std::memcpy(slot->data, &request, sizeof(R));
+		publish(target.requests_, target.max_requests_);
+		Route *route = reserve(*routes_, terminated_);
+		if (!route) {
+			return;
+		}
+		route->control = Route::SHARD;
+		route->shard = shard;
+		publish(*routes_, max_routes_);
+	}
+
+	void push_route(Route::Control control) {
+		if (Route *route = reserve(*routes_, terminated_)) {
+			route->control = control;
+			publish(*routes_, max_routes_);
+		}
+	}
+
+	/// \effects Write the responses of one request of `shard`, which end with a place or a cancel response
+	/// \returns false if the server is terminated
+	bool write_responses(Shard &shard) {
+		while (ResponseSlot *slot = front(shard.responses_, terminated_)) {
+			Response::Data &data = slot->packet().data();
+			bool last = true;
+			switch (data.header.type()) {
+			case Response::PLACE:
+				socket->write(&data.place, sizeof(Response::Place));
+				break;
+			case Response::CANCEL:
+				socket->write(&data.cancel, sizeof(Response::Cancel));
+				break;
+			case Response::MATCH:
+				socket->write(&data.match, sizeof(Response::Match));
+				last = false;
+				break;
+			}
+			shard.responses_.pop();
+			if (last) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void writer_body() {
+		while (Route *route = front(*routes_, terminated_)) {
+			switch (route->control) {
+			case Route::SHARD:
+				if (!write_responses(*shards_[route->shard])) {
+					return;
+				}
+				break;
+			case Route::FLUSH:
+				socket->flush();
+				break;
+			case Route::CLOSE:
+				socket->flush();
+				closed_ = 1;
+				utility::futex::futex(&closed_, FUTEX_WAKE_PRIVATE, 1);
+				break;
+			}
+			routes_->pop();
+		}
+	}
+};
+
+}
+
+using server::Server;
+
+}
@@ -1,6 +1,16 @@
 #ifndef PIEX_HEADER_SERVER
 #define PIEX_HEADER_SERVER
 
-#include "src/server/trivial.h"
+#include "config/config.h"
+
+#if PIEX_OPTION_SERVER == PIEX_OPTION_SERVER_PIPELINED
+	#include "src/server/pipelined.h"
+#elif PIEX_OPTION_SERVER == PIEX_OPTION_SERVER_EPOLL
+	#include "src/server/epoll.h"
+#elif PIEX_OPTION_SERVER == PIEX_OPTION_TRIVIAL
+	#include "src/server/trivial.h"
+#else
+	#error "Invalid PIEX_OPTION_SERVER"
+#endif
 
 #endif
@@ -1,44 +1,71 @@
+#include <unistd.h>
 #include <cerrno>
+#include <cstdint>
 #include <cstring>
 #include <stdexcept>
 #include <memory>
-#include "src/exchange/exchange.h"
+#include "src/exchange/market.h"
 #include "src/packets/packets.h"
 #include "src/socket/socket.h"
+#include "src/snapshot/snapshot.h"
+#include "src/server/flush.h"
+#include "src/utility/thread.h"
 
 namespace piex {
 class Server {
 public:
-	Server() : exchange_(*this) {}
+	Server() : market_(*this) {}
+
+	/// \effects Restore the order books from `path` if it exists and take a snapshot into it every `interval` requests
+	/// \param path The snapshot file
+	/// \param interval The number of requests between two snapshots
+	void snapshot(const char *path, std::uint64_t interval) {
+		if (::access(path, F_OK) == 0) {
+			market_.restore(path);
+		}
+		snapshotter_.enable(path, interval, market_.sequence());
+	}
 
 	/// \effects Listen on specified host and port
 	/// \param host The host to listen at
 	/// \param port The port to listen at
-	/// \remarks The behavior is undefined if clients send invalid data
+	/// \remarks The behavior is undefined if clients send invalid data. The calling thread is placed as the matching thread of `utility::thread::affinity()`
 	void listen(const char *host, const char *port) {
+		utility::thread::place(pthread_self(), utility::thread::affinity().matching);
 		sck_listen.listen(host, port);
-		std::uint8_t buf[sizeof(Request)];
-		Request &request = *reinterpret_cast<Request *>(buf);
 		while (true) {
 			socket = std::make_unique<Socket>(sck_listen.accept());
-			while (true) {
-				int ret = socket->read(&request.data(), sizeof(Request::Header));
-				if (!ret) {
+			while (const void *header = socket->peek(sizeof(Request::Header))) {
+				std::size_t size = Request::size(static_cast<const Request::Header *>(header)->type());
+				const void *data = socket->peek(size);
+				if (!data) {
 					break;
 				}
-				switch (request.data().header.type()) {
+				// decoded in place from the socket buffer, which stays valid until `consume`
+				const Request::Data &request = *static_cast<const Request::Data *>(data);
+				switch (request.header.type()) {
 				case Request::PLACE:
-					socket->read(&request.data(), sizeof(Request::Place), sizeof(Request::Header));
-					exchange_.process_request(request.data().place);
+					market_.process_request(request.place);
+					snapshotter_.poll(market_);
+					flusher_.processed();
 					break;
 				case Request::CANCEL:
-					socket->read(&request.data(), sizeof(Request::Cancel), sizeof(Request::Header));
-					exchange_.process_request(request.data().cancel);
+					market_.process_request(request.cancel);
+					snapshotter_.poll(market_);
+					flusher_.processed();
 					break;
 				case Request::FLUSH:
 					socket->flush();
+					flusher_.flushed();
 					break;
 				}
+				socket->consume(size);
+#if PIEX_OPTION_SERVER_IMPLICIT_FLUSH
+				if (flusher_.due(*socket)) {
+					socket->flush();
+					flusher_.flushed();
+				}
+#endif
 			}
 		}
 	}
@@ -52,7 +79,9 @@ public:
 		socket->write(&response, sizeof(response));
 	}
 private:
-	Exchange<Server> exchange_;
+	Market<Server> market_;
+	snapshot::Scheduler snapshotter_;
+	server::Flusher flusher_;
 	Socket sck_listen;
 	std::unique_ptr<Socket> socket;
 };
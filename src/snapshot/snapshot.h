@@ -0,0 +1,6 @@
+#ifndef PIEX_HEADER_SNAPSHOT
+#define PIEX_HEADER_SNAPSHOT
+
+#include "src/snapshot/trivial.h"
+
+#endif
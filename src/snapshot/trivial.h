@@ -0,0 +1,298 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include "src/order/order.h"
+
+// must be little-endian
+
+namespace piex {
+namespace snapshot {
+
+constexpr std::uint64_t MAGIC = 0x50414e5358454950; // "PIEXSNAP"
+constexpr std::uint32_t VERSION = 2;
+
+/// \remarks Layout of a snapshot file: `Header`, followed by `instruments` sections. Each section is a `SectionHeader`, followed by `buy_size` buy orders and `sell_size` sell orders, each side sorted in priority order
+struct Header {
+	std::uint64_t magic;
+	std::uint32_t version;
+	std::uint32_t order_size;
+	std::uint64_t sequence;
+	std::uint64_t instruments;
+};
+
+struct SectionHeader {
+	std::uint64_t instrument;
+	std::uint64_t buy_size;
+	std::uint64_t sell_size;
+};
+
+/// \remarks The order books of one instrument in a mapped snapshot
+struct Section {
+	Order::InstrumentIdType instrument;
+	const BuyOrder *buy_begin, *buy_end;
+	const SellOrder *sell_begin, *sell_end;
+};
+
+/// \remarks A snapshot being written straight to a mapping of its file, sized in advance. The file at `path` is replaced atomically on `commit`
+/// \remarks Nothing is allocated after construction, so that a child forked from a multithreaded process may write and commit the snapshot
+class File {
+public:
+	/// \effects Create a temporary file next to `path`, map it and write the header
+	/// \param path The snapshot file
+	/// \param sequence The number of requests processed when the snapshot is taken
+	/// \param instruments The number of sections that will be written
+	/// \param orders The number of orders in all sections
+	File(const char *path, std::uint64_t sequence, std::uint64_t instruments, std::uint64_t orders) :
+		path_(path),
+		tmp_path_(path_ + ".tmp"),
+		size_(sizeof(Header) + instruments * sizeof(SectionHeader) + orders * sizeof(Order)) {
+		fd_ = ::open(tmp_path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (fd_ < 0) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+		void *addr = ::ftruncate(fd_, size_) < 0 ? MAP_FAILED : ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+		if (addr == MAP_FAILED) {
+			int error = errno;
+			::close(fd_);
+			::unlink(tmp_path_.c_str());
+			throw std::runtime_error(std::strerror(error));
+		}
+		data_ = static_cast<char *>(addr);
+		Header header = {
+			MAGIC,
+			VERSION,
+			sizeof(Order),
+			sequence,
+			instruments,
+		};
+		write(&header, sizeof(header));
+	}
+	File(const File &) = delete;
+	~File() {
+		if (data_) {
+			::munmap(data_, size_);
+		}
+		if (fd_ != -1) {
+			::close(fd_);
+			::unlink(tmp_path_.c_str());
+		}
+	}
+
+	/// \effects Write the order books of one instrument
+	/// \requires The orders shall fit in the number given on construction
+	template <class B, class S>
+	void write(Order::InstrumentIdType instrument, const B &buy_book, const S &sell_book) {
+		SectionHeader section = {
+			instrument,
+			buy_book.size(),
+			sell_book.size(),
+		};
+		write(&section, sizeof(section));
+		write_side<BuyOrder>(buy_book);
+		write_side<SellOrder>(sell_book);
+	}
+
+	/// \effects Flush the file to disk and move it to `path`
+	void commit() {
+		if (!try_commit()) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+	}
+
+	/// \effects Same as `commit`, with system calls only
+	/// \returns Whether the snapshot is committed. `errno` tells why otherwise
+	bool try_commit() {
+		if (::msync(data_, size_, MS_SYNC) < 0 || ::fsync(fd_) < 0) {
+			return false;
+		}
+		::munmap(data_, size_);
+		data_ = nullptr;
+		::close(fd_);
+		fd_ = -1;
+		return ::rename(tmp_path_.c_str(), path_.c_str()) == 0;
+	}
+
+	/// \effects Unmap and close the file without removing it, leaving it to the child forked to write it
+	void detach() {
+		::munmap(data_, size_);
+		data_ = nullptr;
+		::close(fd_);
+		fd_ = -1;
+	}
+private:
+	std::string path_, tmp_path_;
+	int fd_ = -1;
+	char *data_ = nullptr;
+	std::size_t size_;
+	std::size_t offset_ = 0;
+
+	void write(const void *buf, std::size_t nbytes) {
+		std::memcpy(data_ + offset_, buf, nbytes);
+		offset_ += nbytes;
+	}
+
+	// orders are copied in whatever order the book holds them, then sorted in place, which allocates nothing
+	template <class O, class B>
+	void write_side(const B &book) {
+		O *first = reinterpret_cast<O *>(data_ + offset_);
+		book.for_each_unordered([this](const Order &order) {
+			write(&order, sizeof(order));
+		});
+		O *last = reinterpret_cast<O *>(data_ + offset_);
+		if (!std::is_sorted(first, last)) {
+			std::sort(first, last);
+		}
+	}
+};
+
+/// \remarks A read-only memory mapping of a snapshot file
+class Mapping {
+public:
+	/// \effects Map the snapshot at `path` and validate its layout
+	explicit Mapping(const char *path) {
+		int fd = ::open(path, O_RDONLY);
+		if (fd < 0) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+		struct stat st;
+		if (::fstat(fd, &st) < 0) {
+			::close(fd);
+			throw std::runtime_error(std::strerror(errno));
+		}
+		size_ = st.st_size;
+		if (size_ < sizeof(Header)) {
+			::close(fd);
+			throw std::runtime_error("snapshot truncated");
+		}
+		void *addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+		::close(fd);
+		if (addr == MAP_FAILED) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+		data_ = static_cast<const char *>(addr);
+		try {
+			index();
+		} catch (...) {
+			::munmap(addr, size_);
+			throw;
+		}
+	}
+	Mapping(const Mapping &) = delete;
+	~Mapping() {
+		::munmap(const_cast<char *>(data_), size_);
+	}
+	const Header &header() const {
+		return *reinterpret_cast<const Header *>(data_);
+	}
+	const std::vector<Section> &sections() const {
+		return sections_;
+	}
+private:
+	const char *data_;
+	std::size_t size_;
+	std::vector<Section> sections_;
+
+	void index() {
+		const Header &h = header();
+		if (h.magic != MAGIC || h.version != VERSION || h.order_size != sizeof(Order)) {
+			throw std::runtime_error("snapshot format mismatch");
+		}
+		std::size_t offset = sizeof(Header);
+		for (std::uint64_t i = 0; i < h.instruments; ++i) {
+			if (size_ < offset + sizeof(SectionHeader)) {
+				throw std::runtime_error("snapshot truncated");
+			}
+			const SectionHeader &section = *reinterpret_cast<const SectionHeader *>(data_ + offset);
+			offset += sizeof(SectionHeader);
+			if ((size_ - offset) / sizeof(Order) < section.buy_size + section.sell_size) {
+				throw std::runtime_error("snapshot truncated");
+			}
+			const BuyOrder *buy_begin = reinterpret_cast<const BuyOrder *>(data_ + offset);
+			const SellOrder *sell_begin = reinterpret_cast<const SellOrder *>(buy_begin + section.buy_size);
+			sections_.push_back({
+				static_cast<Order::InstrumentIdType>(section.instrument),
+				buy_begin,
+				buy_begin + section.buy_size,
+				sell_begin,
+				sell_begin + section.sell_size,
+			});
+			offset += (section.buy_size + section.sell_size) * sizeof(Order);
+		}
+	}
+};
+
+/// \remarks Takes snapshots periodically in a forked child so that matching is never stalled by serialization. The copy-on-write address space of the child keeps the books consistent.
+class Scheduler {
+public:
+	Scheduler() = default;
+	Scheduler(const Scheduler &) = delete;
+	~Scheduler() {
+		if (child_ > 0) {
+			::waitpid(child_, nullptr, 0);
+		}
+	}
+
+	/// \effects Enable periodic snapshots
+	/// \param path The snapshot file
+	/// \param interval The number of requests between two snapshots
+	/// \param sequence The sequence number of the current state
+	void enable(const char *path, std::uint64_t interval, std::uint64_t sequence = 0) {
+		path_ = path;
+		interval_ = interval;
+		sequence_ = sequence;
+	}
+	bool enabled() const {
+		return interval_ > 0;
+	}
+	const std::string &path() const {
+		return path_;
+	}
+
+	/// \effects Start a snapshot of `exchange` if `interval_` requests have been processed since the last one
+	/// \remarks A snapshot is postponed while the previous one is still being written
+	/// \remarks Throws if the snapshot cannot be started. The forked child neither allocates nor throws
+	template <class E>
+	void poll(const E &exchange) {
+		if (!enabled() || exchange.sequence() - sequence_ < interval_) {
+			return;
+		}
+		if (child_ > 0) {
+			if (::waitpid(child_, nullptr, WNOHANG) == 0) {
+				return;
+			}
+			child_ = -1;
+		}
+		// the file is created by the parent: other threads may hold the locks of the allocator, which the child would then wait for forever
+		File file = exchange.open_snapshot(path_.c_str());
+		pid_t pid = ::fork();
+		if (pid == 0) {
+			exchange.save(file);
+			_exit(file.try_commit() ? 0 : 1);
+		}
+		if (pid < 0) {
+			throw std::runtime_error(std::string("cannot fork a snapshot: ") + std::strerror(errno));
+		}
+		file.detach();
+		child_ = pid;
+		sequence_ = exchange.sequence();
+	}
+private:
+	std::string path_;
+	std::uint64_t interval_ = 0;
+	std::uint64_t sequence_ = 0;
+	pid_t child_ = -1;
+};
+
+}
+}
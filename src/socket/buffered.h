@@ -2,22 +2,40 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/select.h>
+#include <sys/uio.h>
+#include <poll.h>
 #include <netinet/tcp.h>
 #include <netdb.h>
 #include <cerrno>
+#include <cstdint>
 #include <cstring>
 #include <stdexcept>
 #include <algorithm>
 #include "src/utility/socket.h"
+#if PIEX_OPTION_SOCKET_ZEROCOPY_SIZE > 0
+#include <linux/errqueue.h>
+#endif
 
 namespace piex {
 
+/// \remarks Responses are buffered and sent in one system call on `flush`, or together with the packet that does not fit anymore.
+/// \remarks With `PIEX_OPTION_SOCKET_ZEROCOPY_SIZE` > 0, batches of at least that many bytes are sent with `MSG_ZEROCOPY`: the kernel reads them from the buffer, which is only reused once the kernel reports the send as completed.
 class Socket {
 public:
 	Socket() = default;
-	Socket(Socket &&other) {
-		fd_ = other.fd_;
+	/// \effects Take over the connection of `other` with its buffered input and output and its zero-copy state
+	Socket(Socket &&other) : fd_(other.fd_), read_buf_size_(other.read_buf_size_), write_buf_size_(other.write_buf_size_) {
+#if PIEX_OPTION_SOCKET_ZEROCOPY_SIZE > 0
+		// the kernel may still read the buffers of `other`, which are about to go
+		other.reap(other.zerocopy_sent_);
+		zerocopy_ = other.zerocopy_;
+		zerocopy_sent_ = zerocopy_completed_ = other.zerocopy_sent_;
+		zerocopy_pending_[0] = zerocopy_pending_[1] = zerocopy_sent_;
+#endif
+		std::memcpy(read_buf_, other.read_buf_ + other.read_buf_cursor_, read_buf_size_);
+		std::memcpy(write_buf_[current_], other.write_buf_[other.current_], write_buf_size_);
 		other.fd_ = -1;
+		other.read_buf_size_ = other.write_buf_size_ = 0;
 	}
 	~Socket() {
 		if (fd_ != -1) {
@@ -27,6 +45,7 @@ public:
 	void connect(const char *host, const char *port) {
 		fd_ = utility::socket::create_socket(host, port, false);
 		utility::socket::enable_option(fd_, IPPROTO_TCP, TCP_NODELAY);
+		enable_zerocopy();
 	}
 	void listen(const char *host, const char *port) {
 		fd_ = utility::socket::create_socket(host, port, true);
@@ -55,22 +74,59 @@ public:
 		}
 		return nbytes_total;
 	}
-	int write(const void *buf, size_t nbytes) {
-		if (write_buf_size_ + nbytes >= PIEX_OPTION_SOCKET_BUFFER_SIZE) {
-			flush();
+	const void *peek(size_t n) {
+		if (read_buf_size_ < n) {
+			// move the remainder to the front so that the packet is contiguous
+			std::memmove(read_buf_, read_buf_ + read_buf_cursor_, read_buf_size_);
+			read_buf_cursor_ = 0;
+			while (read_buf_size_ < n) {
+				int ret = ::read(fd_, read_buf_ + read_buf_size_, PIEX_OPTION_SOCKET_BUFFER_SIZE - read_buf_size_);
+				if (ret <= 0) {
+					return nullptr;
+				}
+				read_buf_size_ += ret;
+			}
 		}
+		return read_buf_ + read_buf_cursor_;
+	}
+	void consume(size_t n) {
+		read_buf_cursor_ += n;
+		read_buf_size_ -= n;
+	}
+	int write(const void *buf, size_t nbytes) {
 		if (write_buf_size_ + nbytes >= PIEX_OPTION_SOCKET_BUFFER_SIZE) {
-			::write(fd_, buf, nbytes);
+			// the batch and the packet go out together
+			iovec iov[2] = {
+				{ write_buf_[current_], write_buf_size_ },
+				{ const_cast<void *>(buf), nbytes },
+			};
+			send(iov, 2, 0);
+			write_buf_size_ = 0;
 		} else {
-			std::memcpy(write_buf_ + write_buf_size_, buf, nbytes);
+			std::memcpy(write_buf_[current_] + write_buf_size_, buf, nbytes);
 			write_buf_size_ += nbytes;
 		}
 		return nbytes;
 	}
 	int flush() {
-		size_t nbytes_written = ::write(fd_, write_buf_, write_buf_size_);
+		size_t nbytes = write_buf_size_;
+		if (nbytes == 0) {
+			return 0;
+		}
+		iovec iov = { write_buf_[current_], nbytes };
 		write_buf_size_ = 0;
-		return nbytes_written;
+#if PIEX_OPTION_SOCKET_ZEROCOPY_SIZE > 0
+		if (zerocopy_ && nbytes >= PIEX_OPTION_SOCKET_ZEROCOPY_SIZE) {
+			// the kernel reads the buffer after `sendmsg` returns: switch to the other one, waiting until the kernel is done with it
+			send(&iov, 1, MSG_ZEROCOPY);
+			zerocopy_pending_[current_] = zerocopy_sent_;
+			current_ ^= 1;
+			reap(zerocopy_pending_[current_]);
+			return nbytes;
+		}
+#endif
+		send(&iov, 1, 0);
+		return nbytes;
 	}
 	bool read_ready() {
 		if (read_buf_size_) {
@@ -87,17 +143,108 @@ public:
 		::close(fd_);
 		fd_ = -1;
 	}
+#if PIEX_OPTION_SOCKET_ZEROCOPY_SIZE > 0
+	/// \returns Whether large batches are sent with `MSG_ZEROCOPY`
+	bool zerocopy() const {
+		return zerocopy_;
+	}
+#endif
 	Socket accept() {
 		Socket socket;
 		socket.fd_ = ::accept(fd_, nullptr, nullptr);
+		socket.enable_zerocopy();
 		return socket;
 	}
 private:
 	int fd_ = -1;
 	char read_buf_[PIEX_OPTION_SOCKET_BUFFER_SIZE];
-	char write_buf_[PIEX_OPTION_SOCKET_BUFFER_SIZE];
+	// responses are buffered in one of the two, the other may still be read by the kernel after a zero-copy send
+	char write_buf_[2][PIEX_OPTION_SOCKET_BUFFER_SIZE];
 	size_t read_buf_cursor_ = 0, read_buf_size_ = 0;
 	size_t write_buf_size_ = 0;
+	size_t current_ = 0;
+#if PIEX_OPTION_SOCKET_ZEROCOPY_SIZE > 0
+	bool zerocopy_ = false;
+	// zero-copy sends are numbered from 0 by the kernel; counts of sends issued and completed
+	std::uint32_t zerocopy_sent_ = 0, zerocopy_completed_ = 0;
+	// `zerocopy_sent_` after the last zero-copy send of each buffer
+	std::uint32_t zerocopy_pending_[2] = {};
+#endif
+
+	void enable_zerocopy() {
+#if PIEX_OPTION_SOCKET_ZEROCOPY_SIZE > 0
+		zerocopy_ = utility::socket::enable_option(fd_, SOL_SOCKET, SO_ZEROCOPY) == 0;
+#endif
+	}
+
+	/// \effects Write all bytes of `iov` with as few system calls as possible, resuming after short writes
+	void send(iovec *iov, int iovcnt, int flags) {
+		msghdr msg;
+		std::memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = iov;
+		msg.msg_iovlen = iovcnt;
+		while (msg.msg_iovlen) {
+			ssize_t ret = ::sendmsg(fd_, &msg, MSG_NOSIGNAL | flags);
+			if (ret < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				if (errno == ENOBUFS && flags) {
+					// out of memory to pin pages: copy instead
+					flags = 0;
+					continue;
+				}
+				return;
+			}
+#if PIEX_OPTION_SOCKET_ZEROCOPY_SIZE > 0
+			if (flags & MSG_ZEROCOPY) {
+				++zerocopy_sent_;
+			}
+#endif
+			while (msg.msg_iovlen && static_cast<size_t>(ret) >= msg.msg_iov->iov_len) {
+				ret -= msg.msg_iov->iov_len;
+				++msg.msg_iov;
+				--msg.msg_iovlen;
+			}
+			if (msg.msg_iovlen) {
+				msg.msg_iov->iov_base = static_cast<char *>(msg.msg_iov->iov_base) + ret;
+				msg.msg_iov->iov_len -= ret;
+			}
+		}
+	}
+
+#if PIEX_OPTION_SOCKET_ZEROCOPY_SIZE > 0
+	/// \effects Wait until the kernel has completed the first `count` zero-copy sends
+	void reap(std::uint32_t count) {
+		while (static_cast<std::int32_t>(zerocopy_completed_ - count) < 0) {
+			alignas(cmsghdr) char control[CMSG_SPACE(sizeof(sock_extended_err))];
+			msghdr msg;
+			std::memset(&msg, 0, sizeof(msg));
+			msg.msg_control = control;
+			msg.msg_controllen = sizeof(control);
+			if (::recvmsg(fd_, &msg, MSG_ERRQUEUE) < 0) {
+				if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+					return;
+				}
+				// completions are reported as errors
+				pollfd fds = {fd_, 0, 0};
+				if (::poll(&fds, 1, -1) < 0 || (fds.revents & (POLLHUP | POLLNVAL))) {
+					return;
+				}
+				continue;
+			}
+			for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+				const sock_extended_err *error = reinterpret_cast<const sock_extended_err *>(CMSG_DATA(cmsg));
+				if (error->ee_errno == 0 && error->ee_origin == SO_EE_ORIGIN_ZEROCOPY) {
+					// [ee_info, ee_data] is the range of completed sends
+					if (static_cast<std::int32_t>(error->ee_data + 1 - zerocopy_completed_) > 0) {
+						zerocopy_completed_ = error->ee_data + 1;
+					}
+				}
+			}
+		}
+	}
+#endif
 };
 
 }
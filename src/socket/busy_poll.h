@@ -0,0 +1,178 @@
+#include <unistd.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include "src/utility/socket.h"
+#include "src/utility/cpu.h"
+
+namespace piex {
+
+/// \remarks Buffered socket for dedicated cores. The file descriptor is non-blocking and reads spin on `recv` for `PIEX_OPTION_SOCKET_BUSY_POLL_SPINS` rounds before blocking in `poll`, trading CPU time for scheduler wakeups.
+/// \remarks `PIEX_OPTION_SOCKET_BUSY_POLL_USEC` > 0 additionally sets `SO_BUSY_POLL`, letting the kernel poll the device queue on empty reads. Raising it above `net.core.busy_read` requires `CAP_NET_ADMIN`; failures are ignored.
+class Socket {
+public:
+	Socket() = default;
+	Socket(Socket &&other) {
+		fd_ = other.fd_;
+		other.fd_ = -1;
+	}
+	~Socket() {
+		if (fd_ != -1) {
+			close();
+		}
+	}
+	void connect(const char *host, const char *port) {
+		fd_ = utility::socket::create_socket(host, port, false);
+		utility::socket::enable_option(fd_, IPPROTO_TCP, TCP_NODELAY);
+		set_busy_poll();
+	}
+	void listen(const char *host, const char *port) {
+		fd_ = utility::socket::create_socket(host, port, true);
+		utility::socket::enable_option(fd_, IPPROTO_TCP, TCP_NODELAY);
+		int ret = ::listen(fd_, 0);
+		if (ret < 0) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+	}
+	int read(void *buf, size_t nbytes_total, size_t nbytes_read = 0) {
+		while (nbytes_read < nbytes_total) {
+			if (read_buf_size_ == 0) {
+				ssize_t ret = receive(read_buf_, PIEX_OPTION_SOCKET_BUFFER_SIZE);
+				if (ret <= 0) {
+					return nbytes_read;
+				}
+				read_buf_cursor_ = 0;
+				read_buf_size_ = ret;
+			}
+			size_t nbytes_to_copy = std::min(nbytes_total - nbytes_read, read_buf_size_);
+			std::memcpy(static_cast<char *>(buf) + nbytes_read, read_buf_ + read_buf_cursor_, nbytes_to_copy);
+			nbytes_read += nbytes_to_copy;
+			read_buf_cursor_ += nbytes_to_copy;
+			read_buf_size_ -= nbytes_to_copy;
+		}
+		return nbytes_total;
+	}
+	const void *peek(size_t n) {
+		if (read_buf_size_ < n) {
+			// move the remainder to the front so that the packet is contiguous
+			std::memmove(read_buf_, read_buf_ + read_buf_cursor_, read_buf_size_);
+			read_buf_cursor_ = 0;
+			while (read_buf_size_ < n) {
+				ssize_t ret = receive(read_buf_ + read_buf_size_, PIEX_OPTION_SOCKET_BUFFER_SIZE - read_buf_size_);
+				if (ret <= 0) {
+					return nullptr;
+				}
+				read_buf_size_ += ret;
+			}
+		}
+		return read_buf_ + read_buf_cursor_;
+	}
+	void consume(size_t n) {
+		read_buf_cursor_ += n;
+		read_buf_size_ -= n;
+	}
+	int write(const void *buf, size_t nbytes) {
+		if (write_buf_size_ + nbytes >= PIEX_OPTION_SOCKET_BUFFER_SIZE) {
+			flush();
+		}
+		if (write_buf_size_ + nbytes >= PIEX_OPTION_SOCKET_BUFFER_SIZE) {
+			send(buf, nbytes);
+		} else {
+			std::memcpy(write_buf_ + write_buf_size_, buf, nbytes);
+			write_buf_size_ += nbytes;
+		}
+		return nbytes;
+	}
+	int flush() {
+		size_t nbytes_written = send(write_buf_, write_buf_size_);
+		write_buf_size_ = 0;
+		return nbytes_written;
+	}
+	bool read_ready() {
+		if (read_buf_size_) {
+			return true;
+		}
+		fd_set rfds;
+		struct timeval tv = {0, 0};
+		FD_ZERO(&rfds);
+		FD_SET(fd_, &rfds);
+		int ret = select(fd_ + 1, &rfds, nullptr, nullptr, &tv);
+		return ret > 0;
+	}
+	void close() {
+		::close(fd_);
+		fd_ = -1;
+	}
+	Socket accept() {
+		Socket socket;
+		socket.fd_ = ::accept(fd_, nullptr, nullptr);
+		socket.set_busy_poll();
+		return socket;
+	}
+private:
+	int fd_ = -1;
+	char read_buf_[PIEX_OPTION_SOCKET_BUFFER_SIZE];
+	char write_buf_[PIEX_OPTION_SOCKET_BUFFER_SIZE];
+	size_t read_buf_cursor_ = 0, read_buf_size_ = 0;
+	size_t write_buf_size_ = 0;
+
+	void set_busy_poll() {
+		utility::socket::set_nonblocking(fd_);
+#if PIEX_OPTION_SOCKET_BUSY_POLL_USEC > 0
+		int usec = PIEX_OPTION_SOCKET_BUSY_POLL_USEC;
+		::setsockopt(fd_, SOL_SOCKET, SO_BUSY_POLL, &usec, sizeof(usec));
+#endif
+	}
+
+	/// \effects Receive at most `len` bytes into `buf`, spinning before blocking
+	/// \returns The number of bytes received. 0 on end of stream, negative on error
+	ssize_t receive(char *buf, size_t len) {
+		while (true) {
+			for (std::uint32_t i = 0; i < PIEX_OPTION_SOCKET_BUSY_POLL_SPINS; ++i) {
+				ssize_t ret = ::recv(fd_, buf, len, 0);
+				if (ret >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+					return ret;
+				}
+				utility::cpu::relax();
+			}
+			wait(POLLIN);
+		}
+	}
+
+	/// \effects Write all of `buf`, spinning while the send buffer is full and blocking when the spin budget runs out
+	/// \returns The number of bytes written
+	size_t send(const void *buf, size_t nbytes) {
+		size_t nbytes_written = 0;
+		std::uint32_t spins = 0;
+		while (nbytes_written < nbytes) {
+			ssize_t ret = ::send(fd_, static_cast<const char *>(buf) + nbytes_written, nbytes - nbytes_written, MSG_NOSIGNAL);
+			if (ret >= 0) {
+				nbytes_written += ret;
+				spins = 0;
+			} else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+				break;
+			} else if (++spins < PIEX_OPTION_SOCKET_BUSY_POLL_SPINS) {
+				utility::cpu::relax();
+			} else {
+				wait(POLLOUT);
+				spins = 0;
+			}
+		}
+		return nbytes_written;
+	}
+
+	void wait(short events) {
+		pollfd fds = {fd_, events, 0};
+		::poll(&fds, 1, -1);
+	}
+};
+
+}
@@ -0,0 +1,354 @@
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include <memory>
+#include "src/utility/socket.h"
+#include "src/utility/io_uring.h"
+
+namespace piex {
+
+namespace io_uring {
+
+#if PIEX_OPTION_SOCKET_IO_URING_SQPOLL
+constexpr unsigned SETUP_FLAGS = IORING_SETUP_SQPOLL;
+#else
+constexpr unsigned SETUP_FLAGS = 0;
+#endif
+
+constexpr unsigned RING_ENTRIES = 8;
+
+/// \remarks Receiving side of a socket. A single multishot receive stays armed and fills buffers provided to the kernel, so data that has already arrived is read without any system call
+class Reader {
+public:
+	explicit Reader(int fd) :
+		fd_(fd),
+		ring_(RING_ENTRIES, SETUP_FLAGS),
+		buffers_(ring_, GROUP, PIEX_OPTION_SOCKET_IO_URING_BUFFERS, PIEX_OPTION_SOCKET_BUFFER_SIZE) {
+		arm();
+		ring_.submit();
+	}
+	Reader(const Reader &) = delete;
+	~Reader() {
+		if (armed_) {
+			io_uring_sqe *sqe = ring_.get_sqe();
+			sqe->opcode = IORING_OP_ASYNC_CANCEL;
+			sqe->addr = RECV;
+			sqe->user_data = CANCEL;
+			while (armed_) {
+				ring_.submit(1);
+				reap();
+			}
+		}
+	}
+
+	/// \effects Copy up to `nbytes` received bytes to `buf`, waiting for data if none is available
+	/// \returns The number of bytes copied. 0 on end of stream
+	std::size_t read(char *buf, std::size_t nbytes) {
+		if (!wait()) {
+			return 0;
+		}
+		Chunk &chunk = chunks_[head_];
+		std::size_t nbytes_to_copy = std::min(nbytes, chunk.size - chunk.offset);
+		std::memcpy(buf, buffers_.buffer(chunk.id) + chunk.offset, nbytes_to_copy);
+		skip(nbytes_to_copy);
+		return nbytes_to_copy;
+	}
+
+	/// \returns The next `nbytes` received bytes in place, waiting for data if none is available. nullptr if they span two buffers or on end of stream
+	const char *front(std::size_t nbytes) {
+		if (!wait()) {
+			return nullptr;
+		}
+		Chunk &chunk = chunks_[head_];
+		return chunk.size - chunk.offset >= nbytes ? buffers_.buffer(chunk.id) + chunk.offset : nullptr;
+	}
+
+	/// \effects Discard `nbytes` bytes returned by `front`
+	void skip(std::size_t nbytes) {
+		Chunk &chunk = chunks_[head_];
+		chunk.offset += nbytes;
+		if (chunk.offset == chunk.size) {
+			buffers_.recycle(chunk.id);
+			head_ = (head_ + 1) % PIEX_OPTION_SOCKET_IO_URING_BUFFERS;
+			--size_;
+		}
+	}
+
+	/// \returns Whether `read` would return without waiting
+	bool ready() {
+		if (size_ == 0) {
+			reap();
+			if (size_ == 0 && !eof_ && !armed_) {
+				arm();
+				ring_.submit();
+			}
+		}
+		return size_ || eof_;
+	}
+private:
+	static constexpr std::uint16_t GROUP = 0;
+	static constexpr std::uint64_t RECV = 1, CANCEL = 2;
+
+	struct Chunk {
+		std::uint16_t id;
+		std::size_t size, offset;
+	};
+
+	int fd_;
+	utility::io_uring::Ring ring_;
+	utility::io_uring::BufferRing buffers_;
+	Chunk chunks_[PIEX_OPTION_SOCKET_IO_URING_BUFFERS];
+	std::size_t head_ = 0, size_ = 0;
+	bool armed_ = false, eof_ = false;
+
+	/// \effects Wait until a received buffer is available
+	/// \returns false on end of stream
+	bool wait() {
+		while (size_ == 0) {
+			reap();
+			if (size_ || eof_) {
+				break;
+			}
+			arm();
+			ring_.submit(1);
+		}
+		return size_;
+	}
+
+	/// \effects Queue a multishot receive unless one is armed
+	void arm() {
+		if (armed_ || eof_) {
+			return;
+		}
+		io_uring_sqe *sqe = ring_.get_sqe();
+		sqe->opcode = IORING_OP_RECV;
+		sqe->fd = fd_;
+		sqe->ioprio = IORING_RECV_MULTISHOT;
+		sqe->flags = IOSQE_BUFFER_SELECT;
+		sqe->buf_group = GROUP;
+		sqe->user_data = RECV;
+		armed_ = true;
+	}
+
+	/// \effects Consume all available completions
+	void reap() {
+		while (io_uring_cqe *cqe = ring_.peek()) {
+			if (cqe->user_data == RECV) {
+				if (cqe->res > 0) {
+					chunks_[(head_ + size_) % PIEX_OPTION_SOCKET_IO_URING_BUFFERS] = {
+						static_cast<std::uint16_t>(cqe->flags >> IORING_CQE_BUFFER_SHIFT),
+						static_cast<std::size_t>(cqe->res),
+						0,
+					};
+					++size_;
+				} else if (cqe->res == 0 || (cqe->res != -ENOBUFS && cqe->res != -ECANCELED)) {
+					eof_ = true;
+				}
+				// the receive is disarmed when running out of buffers, and rearmed once they are consumed
+				if (!(cqe->flags & IORING_CQE_F_MORE)) {
+					armed_ = false;
+				}
+			}
+			ring_.seen();
+		}
+	}
+};
+
+/// \remarks Sending side of a socket. Responses are buffered in registered buffers, and a buffer is written with a single fixed-buffer write once flushed while the next one is being filled
+class Writer {
+public:
+	explicit Writer(int fd) : fd_(fd), ring_(RING_ENTRIES, SETUP_FLAGS) {
+		iovec iov[BUFFERS];
+		for (std::size_t i = 0; i < BUFFERS; ++i) {
+			iov[i].iov_base = buf_[i];
+			iov[i].iov_len = PIEX_OPTION_SOCKET_BUFFER_SIZE;
+		}
+		ring_.register_resource(IORING_REGISTER_BUFFERS, iov, BUFFERS);
+	}
+	Writer(const Writer &) = delete;
+	~Writer() {
+		while (in_flight_ != NONE) {
+			ring_.submit(1);
+			reap();
+		}
+	}
+
+	void write(const char *buf, std::size_t nbytes) {
+		while (nbytes) {
+			std::size_t nbytes_to_copy = std::min(nbytes, PIEX_OPTION_SOCKET_BUFFER_SIZE - size_[current_]);
+			std::memcpy(buf_[current_] + size_[current_], buf, nbytes_to_copy);
+			size_[current_] += nbytes_to_copy;
+			buf += nbytes_to_copy;
+			nbytes -= nbytes_to_copy;
+			if (size_[current_] == PIEX_OPTION_SOCKET_BUFFER_SIZE) {
+				flush();
+			}
+		}
+	}
+
+	/// \effects Submit the current buffer and switch to the next one, waiting for it to be written if necessary
+	/// \returns The number of bytes submitted
+	std::size_t flush() {
+		std::size_t nbytes = size_[current_];
+		if (nbytes == 0) {
+			return 0;
+		}
+		reap();
+		if (in_flight_ == NONE) {
+			send(current_);
+		} else {
+			pending_ = current_;
+		}
+		current_ = (current_ + 1) % BUFFERS;
+		while (in_flight_ == current_ || pending_ == current_) {
+			ring_.submit(1);
+			reap();
+		}
+		ring_.submit();
+		return nbytes;
+	}
+private:
+	static constexpr std::size_t BUFFERS = 2;
+	static constexpr std::size_t NONE = BUFFERS;
+
+	int fd_;
+	utility::io_uring::Ring ring_;
+	char buf_[BUFFERS][PIEX_OPTION_SOCKET_BUFFER_SIZE];
+	std::size_t size_[BUFFERS] = {};
+	std::size_t current_ = 0;
+	// buffers are written one at a time to keep the stream in order
+	std::size_t in_flight_ = NONE, pending_ = NONE;
+	std::size_t offset_ = 0;
+
+	void send(std::size_t i, std::size_t offset = 0) {
+		io_uring_sqe *sqe = ring_.get_sqe();
+		sqe->opcode = IORING_OP_WRITE_FIXED;
+		sqe->fd = fd_;
+		sqe->addr = reinterpret_cast<std::uint64_t>(buf_[i] + offset);
+		sqe->len = size_[i] - offset;
+		sqe->buf_index = i;
+		in_flight_ = i;
+		offset_ = offset;
+	}
+
+	/// \effects Consume all available completions, resubmitting short writes and starting the pending buffer
+	void reap() {
+		while (io_uring_cqe *cqe = ring_.peek()) {
+			std::size_t i = in_flight_;
+			std::size_t offset = offset_ + std::max(cqe->res, 0);
+			ring_.seen();
+			if (cqe->res > 0 && offset < size_[i]) {
+				send(i, offset);
+			} else {
+				// errors drop the buffer as the other backends do
+				size_[i] = 0;
+				in_flight_ = NONE;
+				if (pending_ != NONE) {
+					send(pending_);
+					pending_ = NONE;
+				}
+			}
+			ring_.submit();
+		}
+	}
+};
+
+}
+
+class Socket {
+public:
+	Socket() = default;
+	Socket(Socket &&other) :
+		fd_(other.fd_),
+		reader_(std::move(other.reader_)),
+		writer_(std::move(other.writer_)) {
+		other.fd_ = -1;
+	}
+	~Socket() {
+		if (fd_ != -1) {
+			close();
+		}
+	}
+	void connect(const char *host, const char *port) {
+		fd_ = utility::socket::create_socket(host, port, false);
+		utility::socket::enable_option(fd_, IPPROTO_TCP, TCP_NODELAY);
+		open();
+	}
+	void listen(const char *host, const char *port) {
+		fd_ = utility::socket::create_socket(host, port, true);
+		utility::socket::enable_option(fd_, IPPROTO_TCP, TCP_NODELAY);
+		int ret = ::listen(fd_, 0);
+		if (ret < 0) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+	}
+	int read(void *buf, size_t nbytes_total, size_t nbytes_read = 0) {
+		while (nbytes_read < nbytes_total) {
+			std::size_t ret = reader_->read(static_cast<char *>(buf) + nbytes_read, nbytes_total - nbytes_read);
+			if (!ret) {
+				return nbytes_read;
+			}
+			nbytes_read += ret;
+		}
+		return nbytes_total;
+	}
+	const void *peek(size_t n) {
+		if (staging_.size() == 0) {
+			if (const char *data = reader_->front(n)) {
+				return data;
+			}
+		}
+		// the packet spans two buffers
+		return staging_.peek(*this, n);
+	}
+	void consume(size_t n) {
+		if (staging_.size()) {
+			staging_.consume(n);
+		} else {
+			reader_->skip(n);
+		}
+	}
+	int write(const void *buf, size_t nbytes) {
+		writer_->write(static_cast<const char *>(buf), nbytes);
+		return nbytes;
+	}
+	int flush() {
+		return writer_->flush();
+	}
+	bool read_ready() {
+		return reader_->ready();
+	}
+	void close() {
+		reader_.reset();
+		writer_.reset();
+		::close(fd_);
+		fd_ = -1;
+	}
+	Socket accept() {
+		Socket socket;
+		socket.fd_ = ::accept(fd_, nullptr, nullptr);
+		socket.open();
+		return socket;
+	}
+private:
+	int fd_ = -1;
+	// the reading and the writing side have separate rings, so that they may be used by different threads
+	std::unique_ptr<io_uring::Reader> reader_;
+	std::unique_ptr<io_uring::Writer> writer_;
+	utility::socket::Staging staging_;
+
+	void open() {
+		reader_ = std::make_unique<io_uring::Reader>(fd_);
+		writer_ = std::make_unique<io_uring::Writer>(fd_);
+	}
+};
+
+}
@@ -7,136 +7,109 @@
 #include <stdexcept>
 #include <algorithm>
 #include <utility>
-#include <tuple>
 #include <thread>
 #include <memory>
+#include <mutex>
 #include <condition_variable>
 #include "src/utility/socket.h"
+#include "src/utility/thread.h"
+#include "src/utility/spsc.h"
 #include "config/config.h"
 
 namespace piex {
 namespace socket {
 
+/// \remarks Data moves through a `utility::spsc::Buffer`. Sleeping goes through a mutex and condition variables: every publication (release) takes the mutex to wake up the other side.
 struct Daemon {
 public:
 	~Daemon() {
+		terminate();
 		thread_.join();
 	}
-	std::pair<std::size_t, std::size_t> space_interval() {
-		std::size_t offset, len;
-		if (cursor_ + size_ >= PIEX_OPTION_SOCKET_BUFFER_SIZE) {
-			offset = cursor_ + size_ - PIEX_OPTION_SOCKET_BUFFER_SIZE;
-			len = PIEX_OPTION_SOCKET_BUFFER_SIZE - size_;
-		} else {
-			offset = cursor_ + size_;
-			len = PIEX_OPTION_SOCKET_BUFFER_SIZE - size_ - cursor_;
-		}
-		return {offset, len};
-	}
-	std::pair<std::size_t, std::size_t> data_interval() {
-		std::size_t len;
-		if (cursor_ + size_ >= PIEX_OPTION_SOCKET_BUFFER_SIZE) {
-			len = PIEX_OPTION_SOCKET_BUFFER_SIZE - cursor_;
-		} else {
-			len = size_;
-		}
-		return {cursor_, len};
-	}
-	bool ready_read() {
-		return size_ > 0;
-	}
-	bool ready_write() {
-		return size_ < PIEX_OPTION_SOCKET_BUFFER_SIZE;
-	}
-	template <class F>
-	int read(const F &op) {
-		int offset, len;
-		{
+	/// \returns The number of bytes that may be read, waiting for at least one unless terminated
+	std::size_t wait_data() {
+		std::size_t len = buffer_.readable();
+		if (len == 0) {
 			std::unique_lock<std::mutex> lock(mutex_);
-			data_available_.wait(lock, [this] { return ready_read() || terminated_; });
-			if (!ready_read()) {
-				return 0;
-			}
-			offset = cursor_;
-			std::tie(offset, len) = data_interval();
+			data_available_.wait(lock, [this, &len] { return (len = buffer_.readable()) > 0 || terminated_; });
 		}
-		int ret = op(offset, len);
-		if (ret > 0) {
-			std::lock_guard<std::mutex> lock(mutex_);
-			cursor_ += ret;
-			cursor_ %= PIEX_OPTION_SOCKET_BUFFER_SIZE;
-			size_ -= ret;
-		}
-		return ret;
+		return len;
 	}
-	template <class F>
-	int write(const F &op) {
-		int offset, len;
-		{
+	/// \returns The number of bytes that may be written, waiting for at least one unless terminated
+	std::size_t wait_space() {
+		std::size_t len = buffer_.writable();
+		if (len == 0) {
 			std::unique_lock<std::mutex> lock(mutex_);
-			space_available_.wait(lock, [this] { return ready_write() || terminated_; });
-			if (!ready_write()) {
-				return 0;
-			}
-			std::tie(offset, len) = space_interval();
+			space_available_.wait(lock, [this, &len] { return (len = buffer_.writable()) > 0 || terminated_; });
 		}
-		int ret = op(offset, len);
-		if (ret > 0) {
-			std::lock_guard<std::mutex> lock(mutex_);
-			size_ += ret;
-		}
-		return ret;
+		return len;
+	}
+	/// \effects Make written bytes visible to the consumer
+	void publish() {
+		buffer_.publish();
+		std::lock_guard<std::mutex> lock(mutex_);
+		data_available_.notify_one();
+	}
+	/// \effects Make read bytes available to the producer
+	void release() {
+		buffer_.release();
+		std::lock_guard<std::mutex> lock(mutex_);
+		space_available_.notify_one();
+	}
+	/// \effects Make waits return once nothing is left
+	void terminate() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		terminated_ = true;
+		data_available_.notify_one();
+		space_available_.notify_one();
 	}
 	int fd_ = -1;
-	char buffer_[PIEX_OPTION_SOCKET_BUFFER_SIZE];
-	std::size_t cursor_ = 0, size_ = 0;
+	utility::spsc::Buffer<PIEX_OPTION_SOCKET_BUFFER_SIZE> buffer_;
 	bool terminated_ = false;
 	std::mutex mutex_;
 	std::condition_variable data_available_, space_available_;
 	std::thread thread_;
 protected:
 	template <class Function, class... Args>
-	Daemon(int fd, Function &&f, Args &&...args) : fd_(fd), thread_(f, args...) {};
+	Daemon(int fd, const utility::thread::Placement &placement, Function &&f, Args &&...args) : fd_(fd), thread_(utility::thread::spawn(placement, f, args...)) {};
 };
 
 class ReaderDaemon : public Daemon {
 public:
-	ReaderDaemon(int fd) : Daemon(fd, &ReaderDaemon::body, this) {}
-	~ReaderDaemon() {
-		terminated_ = true;
-		space_available_.notify_one();
-	}
+	ReaderDaemon(int fd) : Daemon(fd, utility::thread::affinity().reader, &ReaderDaemon::body, this) {}
 private:
 	void body() {
 		while (true) {
-			int ret = write([this](std::size_t offset, std::size_t len) {
-				return ::read(fd_, buffer_ + offset, len);
-			});
+			std::size_t len = wait_space();
+			if (len == 0) {
+				return;
+			}
+			ssize_t ret = buffer_.read_from(fd_, len);
 			if (ret <= 0) {
+				// end of stream: make waiting reads return
+				terminate();
 				return;
 			}
-			data_available_.notify_one();
+			publish();
 		}
 	}
 };
 
 class WriterDaemon : public Daemon {
 public:
-	WriterDaemon(int fd) : Daemon(fd, &WriterDaemon::body, this) {}
-	~WriterDaemon() {
-		terminated_ = true;
-		data_available_.notify_one();
-	}
+	WriterDaemon(int fd) : Daemon(fd, utility::thread::affinity().writer, &WriterDaemon::body, this) {}
 private:
 	void body() {
 		while (true) {
-			int ret = read([this](std::size_t offset, std::size_t len) {
-				return ::write(fd_, buffer_ + offset, len);
-			});
-			if (ret <= 0 || terminated_) {
+			std::size_t len = wait_data();
+			if (len == 0) {
+				return;
+			}
+			ssize_t ret = buffer_.write_to(fd_, len);
+			if (ret <= 0) {
 				return;
 			}
-			space_available_.notify_one();
+			release();
 		}
 	}
 };
@@ -169,40 +142,40 @@ public:
 	}
 	int read(void *buf, std::size_t nbytes_total, std::size_t nbytes_read = 0) {
 		while (nbytes_read < nbytes_total) {
-			int ret = reader_->read([this, &buf, &nbytes_total, &nbytes_read](std::size_t offset, std::size_t len) {
-				std::size_t nbytes_to_copy = std::min(len, nbytes_total - nbytes_read);
-				std::memcpy(static_cast<char *>(buf) + nbytes_read, reader_->buffer_ + offset, nbytes_to_copy);
-				return nbytes_to_copy;
-			});
-			if (ret <= 0) {
+			std::size_t len = std::min(reader_->wait_data(), nbytes_total - nbytes_read);
+			if (len == 0) {
 				break;
 			}
-			nbytes_read += ret;
-			reader_->space_available_.notify_one();
+			reader_->buffer_.read(static_cast<char *>(buf) + nbytes_read, len);
+			nbytes_read += len;
+			reader_->release();
 		}
 		return nbytes_read;
 	}
 	int write(const void *buf, std::size_t nbytes_total) {
 		std::size_t nbytes_written = 0;
 		while (nbytes_written < nbytes_total) {
-			int ret = writer_->write([this, &buf, &nbytes_total, &nbytes_written](std::size_t offset, std::size_t len) {
-				std::size_t nbytes_to_copy = std::min(len, nbytes_total - nbytes_written);
-				std::memcpy(writer_->buffer_ + offset, static_cast<const char *>(buf) + nbytes_written, nbytes_to_copy);
-				return nbytes_to_copy;
-			});
-			if (ret <= 0) {
+			std::size_t len = std::min(writer_->wait_space(), nbytes_total - nbytes_written);
+			if (len == 0) {
 				break;
 			}
-			nbytes_written += ret;
-			writer_->data_available_.notify_one();
+			writer_->buffer_.write(static_cast<const char *>(buf) + nbytes_written, len);
+			nbytes_written += len;
+			writer_->publish();
 		}
 		return nbytes_written;
 	}
+	const void *peek(std::size_t n) {
+		return staging_.peek(*this, n);
+	}
+	void consume(std::size_t n) {
+		staging_.consume(n);
+	}
 	int flush() {
 		return 0;
 	}
 	bool read_ready() {
-		return reader_->size_ > 0;
+		return reader_->buffer_.readable() > 0;
 	}
 	void close() {
 		::shutdown(fd_, SHUT_RDWR);
@@ -221,6 +194,7 @@ private:
 	int fd_ = -1;
 	std::unique_ptr<ReaderDaemon> reader_;
 	std::unique_ptr<WriterDaemon> writer_;
+	utility::socket::Staging staging_;
 	void start_daemon() {
 		reader_ = std::make_unique<ReaderDaemon>(fd_);
 		writer_ = std::make_unique<WriterDaemon>(fd_);
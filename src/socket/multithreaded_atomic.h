@@ -7,130 +7,67 @@
 #include <stdexcept>
 #include <algorithm>
 #include <utility>
-#include <tuple>
 #include <thread>
 #include <memory>
-#include <atomic>
-#include <condition_variable>
 #include "src/utility/socket.h"
+#include "src/utility/thread.h"
+#include "src/utility/spsc.h"
 #include "config/config.h"
 
 namespace piex {
 namespace socket {
 
-class Buffer {
-public:
-	Buffer(std::mutex *mutex, std::size_t cursor, std::size_t size) : mutex_(mutex), cursor_(cursor), size_(size) {}
-	Buffer(std::mutex *mutex) : Buffer(mutex, 0, 0) {}
-	std::pair<std::size_t, std::size_t> lock_interval(std::size_t n) {
-		if (size_.load() == 0) {
-			std::unique_lock<std::mutex> lock(*mutex_);
-			nonempty_.wait(lock, [this] { return terminated_ || size_.load() > 0; });
-			if (size_.load() == 0) {
-				return {0, 0};
-			}
-		}
-		std::size_t size = size_.load();
-		std::size_t cursor = cursor_;
-		std::size_t len;
-		do {
-			len = std::min({n, size, PIEX_OPTION_SOCKET_BUFFER_SIZE - cursor_});
-		} while (!size_.compare_exchange_strong(size, size - len));
-		cursor_ += len;
-		cursor_ %= PIEX_OPTION_SOCKET_BUFFER_SIZE;
-		return {cursor, len};
-	}
-	void release(std::size_t n) {
-		cursor_ += PIEX_OPTION_SOCKET_BUFFER_SIZE - n; // avoid underflow
-		cursor_ %= PIEX_OPTION_SOCKET_BUFFER_SIZE;
-		size_ += n;
-	}
-	template <class F>
-	std::size_t lock(const F &op) {
-		size_t offset, len;
-		std::tie(offset, len) = lock_interval(PIEX_OPTION_SOCKET_BUFFER_SIZE);
-		if (len == 0) {
-			return 0;
-		}
-		int ret = op(offset, len);
-		if (ret > 0 && static_cast<unsigned>(ret) < len) {
-			release(len - ret);
-		}
-		return ret;
-	}
-	void expand(std::size_t n) {
-		if (size_.fetch_add(n) == 0) {
-			std::lock_guard<std::mutex> lock(*mutex_);
-			nonempty_.notify_one();
-		}
-	}
-	bool nonempty() {
-		return size_.load() > 0;
-	}
-	void terminate() {
-		std::lock_guard<std::mutex> lock(*mutex_);
-		terminated_ = true;
-		nonempty_.notify_one();
-	}
-private:
-	bool terminated_ = false;
-	std::mutex *mutex_;
-	std::condition_variable nonempty_;
-	std::size_t cursor_;
-	volatile std::atomic_size_t size_;
-};
-
+/// \remarks Data moves through a `utility::spsc::Buffer`. Bytes are published (released) at the end of every socket call, and a side waiting for data (space) sleeps on the futex of the ring.
 struct Daemon {
 public:
 	~Daemon() {
-		data_.terminate();
-		space_.terminate();
+		buffer_.close();
 		thread_.join();
 	}
 	int fd_ = -1;
-	char buffer_[PIEX_OPTION_SOCKET_BUFFER_SIZE];
-	std::mutex mutex_;
-	Buffer data_, space_;
+	utility::spsc::Buffer<PIEX_OPTION_SOCKET_BUFFER_SIZE> buffer_;
 	std::thread thread_;
 protected:
 	template <class Function, class... Args>
-	Daemon(int fd, Function &&f, Args &&...args) :
+	Daemon(int fd, const utility::thread::Placement &placement, Function &&f, Args &&...args) :
 		fd_(fd),
-		data_(&mutex_, 0, 0),
-		space_(&mutex_, 0, PIEX_OPTION_SOCKET_BUFFER_SIZE),
-		thread_(f, args...) {};
+		thread_(utility::thread::spawn(placement, f, args...)) {};
 };
 
 class ReaderDaemon : public Daemon {
 public:
-	ReaderDaemon(int fd) : Daemon(fd, &ReaderDaemon::body, this) {}
+	ReaderDaemon(int fd) : Daemon(fd, utility::thread::affinity().reader, &ReaderDaemon::body, this) {}
 private:
 	void body() {
 		while (true) {
-			int ret = space_.lock([this](std::size_t offset, std::size_t len) {
-				return ::read(fd_, buffer_ + offset, len);
-			});
+			std::size_t len = buffer_.wait_writable(1);
+			if (len == 0) {
+				return;
+			}
+			ssize_t ret = buffer_.read_from(fd_, len);
 			if (ret <= 0) {
+				// end of stream: make waiting reads return
+				buffer_.close();
 				return;
 			}
-			data_.expand(ret);
 		}
 	}
 };
 
 class WriterDaemon : public Daemon {
 public:
-	WriterDaemon(int fd) : Daemon(fd, &WriterDaemon::body, this) {}
+	WriterDaemon(int fd) : Daemon(fd, utility::thread::affinity().writer, &WriterDaemon::body, this) {}
 private:
 	void body() {
 		while (true) {
-			int ret = data_.lock([this](std::size_t offset, std::size_t len) {
-				return ::write(fd_, buffer_ + offset, len);
-			});
+			std::size_t len = buffer_.wait_readable(1);
+			if (len == 0) {
+				return;
+			}
+			ssize_t ret = buffer_.write_to(fd_, len);
 			if (ret <= 0) {
 				return;
 			}
-			space_.expand(ret);
 		}
 	}
 };
@@ -163,40 +100,40 @@ public:
 	}
 	int read(void *buf, size_t nbytes_total, size_t nbytes_read = 0) {
 		while (nbytes_read < nbytes_total) {
-			int ret = reader_->data_.lock([this, &buf, &nbytes_total, &nbytes_read](size_t offset, size_t len) {
-				size_t nbytes_to_copy = std::min(len, nbytes_total - nbytes_read);
-				std::memcpy(static_cast<char *>(buf) + nbytes_read, reader_->buffer_ + offset, nbytes_to_copy);
-				return nbytes_to_copy;
-			});
-			if (ret <= 0) {
+			size_t len = std::min(reader_->buffer_.wait_readable(1), nbytes_total - nbytes_read);
+			if (len == 0) {
 				break;
 			}
-			reader_->space_.expand(ret);
-			nbytes_read += ret;
+			reader_->buffer_.read(static_cast<char *>(buf) + nbytes_read, len);
+			nbytes_read += len;
 		}
+		reader_->buffer_.release();
 		return nbytes_read;
 	}
 	int write(const void *buf, size_t nbytes_total) {
 		size_t nbytes_written = 0;
 		while (nbytes_written < nbytes_total) {
-			int ret = writer_->space_.lock([this, &buf, &nbytes_total, &nbytes_written](size_t offset, size_t len) {
-				size_t nbytes_to_copy = std::min(len, nbytes_total - nbytes_written);
-				std::memcpy(writer_->buffer_ + offset, static_cast<const char *>(buf) + nbytes_written, nbytes_to_copy);
-				return nbytes_to_copy;
-			});
-			if (ret <= 0) {
+			size_t len = std::min(writer_->buffer_.wait_writable(1), nbytes_total - nbytes_written);
+			if (len == 0) {
 				break;
 			}
-			writer_->data_.expand(ret);
-			nbytes_written += ret;
+			writer_->buffer_.write(static_cast<const char *>(buf) + nbytes_written, len);
+			nbytes_written += len;
 		}
+		writer_->buffer_.publish();
 		return nbytes_written;
 	}
+	const void *peek(std::size_t n) {
+		return staging_.peek(*this, n);
+	}
+	void consume(std::size_t n) {
+		staging_.consume(n);
+	}
 	int flush() {
 		return 0;
 	}
 	bool read_ready() {
-		return reader_->data_.nonempty();
+		return reader_->buffer_.readable() > 0;
 	}
 	void close() {
 		::shutdown(fd_, SHUT_RDWR);
@@ -215,6 +152,7 @@ private:
 	int fd_ = -1;
 	std::unique_ptr<ReaderDaemon> reader_;
 	std::unique_ptr<WriterDaemon> writer_;
+	utility::socket::Staging staging_;
 	void start_daemon() {
 		reader_ = std::make_unique<ReaderDaemon>(fd_);
 		writer_ = std::make_unique<WriterDaemon>(fd_);
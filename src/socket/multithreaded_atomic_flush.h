@@ -13,88 +13,132 @@
 #include <thread>
 #include <memory>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include "src/utility/socket.h"
-#include "src/utility/circular.h"
+#include "src/utility/thread.h"
+#include "src/utility/spsc.h"
 #include "src/nsemaphore/nsemaphore.h"
 #include "config/config.h"
 
 namespace piex {
 namespace socket {
 
-template <class Semaphore, std::size_t N>
-struct Interval {
-	Interval(std::size_t size) : size_(size) {}
-	utility::circular::circular<std::size_t, N> cursor_ = 0;
-	Semaphore size_;
-};
-
-template <class DataSemaphore, class SpaceSemaphore>
+/// \remarks Data moves through a `utility::spsc::Buffer` in batches. The nsemaphores are only used to sleep and are updated once per batch: `data_` counts published bytes not yet released and `space_` counts bytes that may be published. The buffer is mirror-mapped if `PIEX_OPTION_SOCKET_BUFFER_SIZE` is a multiple of the page size, so that packets are never split at its end; otherwise the packets split at its end are peeked through a copy.
 struct Daemon {
 public:
 	~Daemon() {
-		data_.size_.terminate();
-		space_.size_.terminate();
+		data_.terminate();
+		space_.terminate();
 		thread_.join();
 	}
 	int fd_ = -1;
-	utility::circular::Buffer<PIEX_OPTION_SOCKET_BUFFER_SIZE> buffer_;
-	Interval<DataSemaphore, PIEX_OPTION_SOCKET_BUFFER_SIZE> data_ = 0;
-	Interval<SpaceSemaphore, PIEX_OPTION_SOCKET_BUFFER_SIZE> space_ = PIEX_OPTION_SOCKET_BUFFER_SIZE;
+	utility::spsc::Buffer<PIEX_OPTION_SOCKET_BUFFER_SIZE, utility::circular::Mirror<PIEX_OPTION_SOCKET_BUFFER_SIZE>> buffer_;
+	alignas(utility::spsc::CACHE_LINE_SIZE) nsemaphore::Strict data_{0};
+	alignas(utility::spsc::CACHE_LINE_SIZE) nsemaphore::Strict space_{PIEX_OPTION_SOCKET_BUFFER_SIZE};
 	std::thread thread_;
+
+	/// \effects Make written bytes visible to the consumer
+	/// \returns The number of bytes published
+	std::size_t publish() {
+		std::size_t n = buffer_.publish();
+		if (n) {
+			space_.consume(n);
+			data_.post(n);
+		}
+		return n;
+	}
+	/// \effects Make read bytes available to the producer
+	void release() {
+		std::size_t n = buffer_.release();
+		if (n) {
+			data_.consume(n);
+			space_.post(n);
+		}
+	}
 protected:
 	template <class Function, class... Args>
-	Daemon(int fd, Function &&f, Args &&...args) :
+	Daemon(int fd, const utility::thread::Placement &placement, Function &&f, Args &&...args) :
 		fd_(fd),
-		thread_(f, args...) {};
+		thread_(utility::thread::spawn(placement, f, args...)) {};
 };
 
-class ReaderDaemon : public Daemon<nsemaphore::Strict, nsemaphore::Loose> {
+class ReaderDaemon : public Daemon {
 public:
-	ReaderDaemon(int fd) : Daemon(fd, &ReaderDaemon::body, this) {}
+	ReaderDaemon(int fd) : Daemon(fd, utility::thread::affinity().reader, &ReaderDaemon::body, this) {}
 private:
 	void body() {
 		while (true) {
-			space_.size_.wait(PIEX_OPTION_SOCKET_FLUSH_THRESHOLD);
-			std::size_t offset = space_.cursor_;
-			std::size_t len = space_.size_.load();
-			if (len == 0) {
+			space_.wait(PIEX_OPTION_SOCKET_FLUSH_THRESHOLD);
+			std::size_t len = buffer_.writable(PIEX_OPTION_SOCKET_FLUSH_THRESHOLD);
+			if (len < PIEX_OPTION_SOCKET_FLUSH_THRESHOLD) {
 				return;
 			}
-			ssize_t ret = buffer_.read_from(fd_, offset, len);
+			ssize_t ret = buffer_.read_from(fd_, len);
 			if (ret <= 0) {
+				// end of stream: make waiting reads return
+				data_.terminate();
 				return;
 			}
-			space_.cursor_ += ret;
-			space_.size_.consume(ret);
-			data_.size_.post(ret);
+			publish();
 		}
 	}
 };
 
-class WriterDaemon : public Daemon<nsemaphore::Loose, nsemaphore::Strict> {
+class WriterDaemon : public Daemon {
 public:
-	WriterDaemon(int fd) : Daemon(fd, &WriterDaemon::body, this) {}
+	WriterDaemon(int fd) : Daemon(fd, utility::thread::affinity().writer, &WriterDaemon::body, this) {}
 private:
 	void body() {
 		while (true) {
-			data_.size_.wait(PIEX_OPTION_SOCKET_FLUSH_THRESHOLD);
-			std::size_t offset = data_.cursor_;
-			std::size_t len = data_.size_.load();
+			data_.wait(1);
+			std::size_t len = buffer_.readable();
 			if (len == 0) {
 				return;
 			}
-			ssize_t ret = buffer_.write_to(fd_, offset, len);
+			ssize_t ret = buffer_.write_to(fd_, len);
 			if (ret <= 0) {
 				return;
 			}
-			data_.cursor_ += ret;
-			data_.size_.consume(ret);
-			space_.size_.post(ret);
+			release();
 		}
 	}
 };
 
+/// \remarks The number of written bytes after which they are handed to the writer daemon. With `PIEX_OPTION_SOCKET_FLUSH_LATENCY_USEC` > 0 it follows the rate at which bytes are written, so that a byte waits about that long before being handed over: a few bytes when quiet, for latency, and up to `PIEX_OPTION_SOCKET_FLUSH_THRESHOLD` when busy, for batching. Otherwise it stays at `PIEX_OPTION_SOCKET_FLUSH_THRESHOLD`.
+/// \remarks The rate is a moving average updated on every handover, so the clock is not read on every write
+class FlushThreshold {
+public:
+	/// \returns The current threshold in bytes. May be called from any thread
+	std::size_t value() const {
+		return value_.load(std::memory_order_relaxed);
+	}
+	/// \effects Account for `n` bytes handed over
+	void published(std::size_t n) {
+#if PIEX_OPTION_SOCKET_FLUSH_LATENCY_USEC > 0
+		auto now = std::chrono::steady_clock::now();
+		double elapsed = std::chrono::duration<double, std::micro>(now - last_).count();
+		last_ = now;
+		if (elapsed <= 0) {
+			return;
+		}
+		// bytes per microsecond
+		rate_ += (n / elapsed - rate_) * WEIGHT;
+		double value = rate_ * PIEX_OPTION_SOCKET_FLUSH_LATENCY_USEC;
+		value_.store(value < 1 ? 1 : std::min<std::size_t>(value, PIEX_OPTION_SOCKET_FLUSH_THRESHOLD), std::memory_order_relaxed);
+#else
+		static_cast<void>(n);
+#endif
+	}
+private:
+	std::atomic_size_t value_ = PIEX_OPTION_SOCKET_FLUSH_THRESHOLD;
+#if PIEX_OPTION_SOCKET_FLUSH_LATENCY_USEC > 0
+	static constexpr double WEIGHT = 0.125;
+	double rate_ = 0;
+	std::chrono::steady_clock::time_point last_ = std::chrono::steady_clock::now();
+#endif
+};
+
 // not thread safe
 class Socket {
 public:
@@ -126,38 +170,70 @@ public:
 	ssize_t read(void *buf, std::size_t nbytes_total, std::size_t nbytes_read = 0) {
 		std::size_t nbytes_to_read = nbytes_total - nbytes_read;
 		assert(nbytes_to_read <= PIEX_OPTION_SOCKET_BUFFER_SIZE - PIEX_OPTION_SOCKET_FLUSH_THRESHOLD);
-		reader_->data_.size_.wait(nbytes_to_read);
-		std::size_t offset = reader_->data_.cursor_;
-		std::size_t len = nbytes_to_read;
-		reader_->data_.size_.consume(len);
-		if (len == 0) {
-			return 0;
+		if (reader_->buffer_.readable(nbytes_to_read) < nbytes_to_read) {
+			reader_->release();
+			reader_->data_.wait(nbytes_to_read);
+			if (reader_->buffer_.readable(nbytes_to_read) < nbytes_to_read) {
+				return 0;
+			}
+		}
+		reader_->buffer_.read(static_cast<char *>(buf) + nbytes_read, nbytes_to_read);
+		if (reader_->buffer_.unreleased() >= PIEX_OPTION_SOCKET_FLUSH_THRESHOLD) {
+			reader_->release();
 		}
-		reader_->data_.cursor_ += len;
-		reader_->buffer_.read(static_cast<char *>(buf) + nbytes_read, offset, len);
-		reader_->space_.size_.post(nbytes_to_read);
 		return nbytes_total;
 	}
+	const void *peek(std::size_t n) {
+		if (staging_.size() == 0) {
+			if (reader_->buffer_.readable(n) < n) {
+				reader_->release();
+				reader_->data_.wait(n);
+				if (reader_->buffer_.readable(n) < n) {
+					return nullptr;
+				}
+			}
+			if (reader_->buffer_.contiguous(n)) {
+				return reader_->buffer_.front();
+			}
+		}
+		// the packet is split at the end of a buffer that could not be mirrored
+		return staging_.peek(*this, n);
+	}
+	void consume(std::size_t n) {
+		if (staging_.size()) {
+			staging_.consume(n);
+			return;
+		}
+		reader_->buffer_.consume(n);
+		if (reader_->buffer_.unreleased() >= PIEX_OPTION_SOCKET_FLUSH_THRESHOLD) {
+			reader_->release();
+		}
+	}
 	ssize_t write(const void *buf, std::size_t nbytes_total) {
 		assert(nbytes_total <= PIEX_OPTION_SOCKET_BUFFER_SIZE - PIEX_OPTION_SOCKET_FLUSH_THRESHOLD);
-		writer_->space_.size_.wait(nbytes_total);
-		std::size_t offset = writer_->space_.cursor_;
-		std::size_t len = nbytes_total;
-		writer_->space_.size_.consume(len);
-		if (len == 0) {
-			return 0;
+		if (writer_->buffer_.writable(nbytes_total) < nbytes_total) {
+			publish();
+			writer_->space_.wait(nbytes_total);
+			if (writer_->buffer_.writable(nbytes_total) < nbytes_total) {
+				return 0;
+			}
+		}
+		writer_->buffer_.write(buf, nbytes_total);
+		if (writer_->buffer_.unpublished() >= threshold_.value()) {
+			publish();
 		}
-		writer_->space_.cursor_ += len;
-		writer_->buffer_.write(buf, offset, len);
-		writer_->data_.size_.post(nbytes_total);
 		return nbytes_total;
 	}
 	int flush() {
-		writer_->data_.size_.flush();
+		publish();
 		return 0;
 	}
+	/// \returns The number of written bytes after which they are sent without a flush, see `FlushThreshold`
+	std::size_t flush_threshold() const {
+		return threshold_.value();
+	}
 	bool read_ready() {
-		return reader_->data_.size_.load() > 0;
+		return reader_->buffer_.readable() > 0;
 	}
 	void close() {
 		::shutdown(fd_, SHUT_RDWR);
@@ -176,6 +252,14 @@ private:
 	int fd_ = -1;
 	std::unique_ptr<ReaderDaemon> reader_;
 	std::unique_ptr<WriterDaemon> writer_;
+	FlushThreshold threshold_;
+	utility::socket::Staging staging_;
+	void publish() {
+		std::size_t n = writer_->publish();
+		if (n) {
+			threshold_.published(n);
+		}
+	}
 	void start_daemon() {
 		reader_ = std::make_unique<ReaderDaemon>(fd_);
 		writer_ = std::make_unique<WriterDaemon>(fd_);
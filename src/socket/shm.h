@@ -0,0 +1,295 @@
+#include <unistd.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <algorithm>
+#include <memory>
+#include "src/utility/circular.h"
+#include "src/utility/socket.h"
+#include "src/utility/spsc.h"
+
+namespace piex {
+namespace shm {
+
+constexpr std::uint32_t SIZE = PIEX_OPTION_SOCKET_SHM_SIZE;
+static_assert((SIZE & (SIZE - 1)) == 0, "PIEX_OPTION_SOCKET_SHM_SIZE shall be a power of 2");
+
+using Channel = utility::spsc::Control<SIZE, true>;
+using Data = utility::circular::Mirror<SIZE>;
+
+/// \remarks Positions of both rings of a connection. Zero-filled memory is a valid initial state
+struct Shared {
+	Channel to_server;
+	Channel to_client;
+};
+
+/// \remarks Layout of the memory file of a connection: the data of both rings, then their positions. Data offsets are multiples of `SIZE`, so that each ring can be mirror-mapped
+constexpr off_t TO_SERVER_OFFSET = 0;
+constexpr off_t TO_CLIENT_OFFSET = SIZE;
+constexpr off_t SHARED_OFFSET = 2 * SIZE;
+constexpr off_t FILE_SIZE = SHARED_OFFSET + sizeof(Shared);
+
+/// \remarks Sleeps are bounded so that a peer that died without closing is noticed
+constexpr timespec WAIT_TIMEOUT = {0, 100 * 1000 * 1000};
+
+inline sockaddr_un address(const char *host, const char *port, socklen_t &len) {
+	sockaddr_un addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	// abstract namespace: sun_path starts with a null byte and nothing is created on the file system
+	std::string name = std::string("piex-shm:") + host + ":" + port;
+	if (name.size() + 1 > sizeof(addr.sun_path)) {
+		throw std::runtime_error("address too long");
+	}
+	std::memcpy(addr.sun_path + 1, name.data(), name.size());
+	len = offsetof(sockaddr_un, sun_path) + 1 + name.size();
+	return addr;
+}
+
+/// \effects Send `fd` over the Unix domain socket `sock`
+inline void send_fd(int sock, int fd) {
+	char byte = 0;
+	iovec iov = {&byte, 1};
+	alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+	msghdr msg;
+	std::memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+	if (::sendmsg(sock, &msg, MSG_NOSIGNAL) < 0) {
+		throw std::runtime_error(std::strerror(errno));
+	}
+}
+
+/// \returns The file descriptor received from the Unix domain socket `sock`
+inline int receive_fd(int sock) {
+	char byte;
+	iovec iov = {&byte, 1};
+	alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+	msghdr msg;
+	std::memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	if (::recvmsg(sock, &msg, MSG_CMSG_CLOEXEC) <= 0) {
+		throw std::runtime_error("shared memory handshake failed");
+	}
+	cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+		throw std::runtime_error("shared memory handshake failed");
+	}
+	int fd;
+	std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+	return fd;
+}
+
+inline Shared *map(int fd) {
+	void *addr = ::mmap(nullptr, sizeof(Shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, SHARED_OFFSET);
+	if (addr == MAP_FAILED) {
+		throw std::runtime_error(std::strerror(errno));
+	}
+	return static_cast<Shared *>(addr);
+}
+
+}
+
+/// \remarks Connects processes on the same host through a pair of shared-memory rings. `host` and `port` only name the Unix domain socket used for the handshake, in which the client passes a memfd to the server.
+/// \remarks Written data is published to the peer on `flush` or when the ring is full. Rings are mirror-mapped, so `PIEX_OPTION_SOCKET_SHM_SIZE` shall be a multiple of the page size and data is never split at their end.
+class Socket {
+public:
+	Socket() = default;
+	Socket(Socket &&other) :
+		fd_(other.fd_),
+		shared_(other.shared_),
+		in_(other.in_),
+		out_(other.out_),
+		in_data_(std::move(other.in_data_)),
+		out_data_(std::move(other.out_data_)) {
+		other.fd_ = -1;
+		other.shared_ = nullptr;
+	}
+	~Socket() {
+		if (fd_ != -1) {
+			close();
+		}
+	}
+	void connect(const char *host, const char *port) {
+		socklen_t len;
+		sockaddr_un addr = shm::address(host, port, len);
+		fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (fd_ < 0 || ::connect(fd_, reinterpret_cast<sockaddr *>(&addr), len) < 0) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+		int memfd = ::memfd_create("piex-shm", MFD_CLOEXEC);
+		if (memfd < 0) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+		if (::ftruncate(memfd, shm::FILE_SIZE) < 0) {
+			::close(memfd);
+			throw std::runtime_error(std::strerror(errno));
+		}
+		try {
+			open(memfd, false);
+			shm::send_fd(fd_, memfd);
+		} catch (...) {
+			::close(memfd);
+			throw;
+		}
+		::close(memfd);
+	}
+	void listen(const char *host, const char *port) {
+		socklen_t len;
+		sockaddr_un addr = shm::address(host, port, len);
+		fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (fd_ < 0 || ::bind(fd_, reinterpret_cast<sockaddr *>(&addr), len) < 0 || ::listen(fd_, 0) < 0) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+	}
+	int read(void *buf, size_t nbytes_total, size_t nbytes_read = 0) {
+		while (nbytes_read < nbytes_total) {
+			std::size_t available = in_->readable();
+			if (available == 0) {
+				// peers may be waiting for our responses before sending anything more
+				out_->publish();
+				available = wait_readable();
+				if (available == 0) {
+					return nbytes_read;
+				}
+			}
+			std::size_t n = std::min(available, nbytes_total - nbytes_read);
+			in_data_->read(static_cast<char *>(buf) + nbytes_read, in_->read_offset(), n);
+			in_->consume(n);
+			nbytes_read += n;
+		}
+		if (in_->unreleased() >= shm::SIZE / 2) {
+			in_->release();
+		}
+		return nbytes_total;
+	}
+	const void *peek(size_t n) {
+		if (in_->readable(n) < n) {
+			out_->publish();
+			if (wait_readable(n) < n) {
+				return nullptr;
+			}
+		}
+		return in_data_->data(in_->read_offset());
+	}
+	void consume(size_t n) {
+		in_->consume(n);
+		if (in_->unreleased() >= shm::SIZE / 2) {
+			in_->release();
+		}
+	}
+	int write(const void *buf, size_t nbytes) {
+		const char *data = static_cast<const char *>(buf);
+		size_t nbytes_written = 0;
+		while (nbytes_written < nbytes) {
+			std::size_t space = out_->writable();
+			if (space == 0) {
+				space = wait_writable();
+				if (space == 0) {
+					// the peer is gone
+					return nbytes_written;
+				}
+			}
+			std::size_t n = std::min(space, nbytes - nbytes_written);
+			out_data_->write(data + nbytes_written, out_->write_offset(), n);
+			out_->produce(n);
+			nbytes_written += n;
+		}
+		return nbytes;
+	}
+	int flush() {
+		return out_->publish();
+	}
+	bool read_ready() {
+		return in_->readable() > 0 || in_->closed();
+	}
+	void close() {
+		if (shared_) {
+			out_->publish();
+			out_->close();
+			in_->close();
+			::munmap(shared_, sizeof(shm::Shared));
+			shared_ = nullptr;
+			in_data_.reset();
+			out_data_.reset();
+		}
+		::close(fd_);
+		fd_ = -1;
+	}
+	Socket accept() {
+		Socket socket;
+		socket.fd_ = ::accept4(fd_, nullptr, nullptr, SOCK_CLOEXEC);
+		if (socket.fd_ < 0) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+		int memfd = shm::receive_fd(socket.fd_);
+		try {
+			socket.open(memfd, true);
+		} catch (...) {
+			::close(memfd);
+			throw;
+		}
+		::close(memfd);
+		return socket;
+	}
+private:
+	// Unix domain socket of the handshake, kept open to detect the death of the peer
+	int fd_ = -1;
+	shm::Shared *shared_ = nullptr;
+	shm::Channel *in_ = nullptr, *out_ = nullptr;
+	std::unique_ptr<shm::Data> in_data_, out_data_;
+
+	/// \effects Map the rings of the memory file `memfd`
+	void open(int memfd, bool is_server) {
+		in_data_ = std::make_unique<shm::Data>(memfd, is_server ? shm::TO_SERVER_OFFSET : shm::TO_CLIENT_OFFSET);
+		out_data_ = std::make_unique<shm::Data>(memfd, is_server ? shm::TO_CLIENT_OFFSET : shm::TO_SERVER_OFFSET);
+		shared_ = shm::map(memfd);
+		in_ = is_server ? &shared_->to_server : &shared_->to_client;
+		out_ = is_server ? &shared_->to_client : &shared_->to_server;
+	}
+
+	bool peer_alive() {
+		char byte;
+		return ::recv(fd_, &byte, 1, MSG_PEEK | MSG_DONTWAIT) != 0;
+	}
+
+	/// \effects Wait until the peer publishes `n` bytes or closes
+	/// \returns The number of bytes available, which is less than `n` if the peer closed
+	std::size_t wait_readable(std::size_t n = 1) {
+		std::size_t available = 0;
+		while (available < n && !in_->closed() && peer_alive()) {
+			available = in_->wait_readable(n, PIEX_OPTION_SOCKET_SHM_SPINS, &shm::WAIT_TIMEOUT);
+		}
+		return in_->readable(n);
+	}
+
+	/// \effects Publish written data and wait until the peer frees space or closes
+	/// \returns The number of bytes free. 0 if the peer closed
+	std::size_t wait_writable() {
+		std::size_t space = 0;
+		while (space == 0 && !out_->closed() && peer_alive()) {
+			space = out_->wait_writable(1, PIEX_OPTION_SOCKET_SHM_SPINS, &shm::WAIT_TIMEOUT);
+		}
+		return out_->closed() ? 0 : out_->writable();
+	}
+};
+
+}
@@ -11,6 +11,12 @@
 	#include "src/socket/multithreaded_atomic.h"
 #elif PIEX_OPTION_SOCKET == PIEX_OPTION_SOCKET_MULTITHREADED_ATOMIC_FLUSH
 	#include "src/socket/multithreaded_atomic_flush.h"
+#elif PIEX_OPTION_SOCKET == PIEX_OPTION_SOCKET_IO_URING
+	#include "src/socket/io_uring.h"
+#elif PIEX_OPTION_SOCKET == PIEX_OPTION_SOCKET_BUSY_POLL
+	#include "src/socket/busy_poll.h"
+#elif PIEX_OPTION_SOCKET == PIEX_OPTION_SOCKET_SHM
+	#include "src/socket/shm.h"
 #elif PIEX_OPTION_SOCKET == PIEX_OPTION_TRIVIAL
 	#include "src/socket/trivial.h"
 #else
@@ -52,6 +52,15 @@ public:
 		}
 		return nbytes_read;
 	}
+	/// \returns `n` contiguous bytes at the head of the input, waiting for them if necessary, or nullptr on end of stream
+	/// \remarks The bytes stay valid until the next call on this socket and are only removed by `consume`. `n` shall not be greater than `utility::socket::PEEK_SIZE`, and `peek` shall not be mixed with `read` on the same socket
+	const void *peek(size_t n) {
+		return staging_.peek(*this, n);
+	}
+	/// \effects Remove `n` peeked bytes from the head of the input
+	void consume(size_t n) {
+		staging_.consume(n);
+	}
 	/// \effects Write data to socket
 	/// \param buf Data to write
 	/// \param nbytes Number of bytes to write
@@ -87,6 +96,7 @@ public:
 	}
 private:
 	int fd_ = -1;
+	utility::socket::Staging staging_;
 };
 
 }
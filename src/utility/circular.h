@@ -3,9 +3,14 @@
 
 #include <sys/types.h>
 #include <sys/uio.h>
+#include <sys/mman.h>
 #include <unistd.h>
+#include <cerrno>
 #include <cstdint>
 #include <cstring>
+#include <stdexcept>
+#include <initializer_list>
+#include <memory>
 
 namespace piex {
 namespace utility {
@@ -85,10 +90,129 @@ public:
 			std::memcpy(buf_ + offset, static_cast<const char *>(buf), len);
 		}
 	}
+	/// \returns The byte at `offset`. Bytes are contiguous up to the end of the buffer only
+	char *data(std::size_t offset) {
+		return buf_ + offset;
+	}
+	static constexpr bool mirrored() {
+		return false;
+	}
 private:
 	char buf_[N];
 };
 
+/// \remarks Circular buffer whose pages are mapped twice back to back, so that the `len` bytes from any `offset` are contiguous in memory. Nothing is split at the end of the buffer and data may be accessed in place through `data`.
+/// \remarks Pages can only be mirrored if `N` is a multiple of the page size, which depends on the kernel. Otherwise the buffer falls back to a copying `Buffer` and is not `mirrored`.
+template <std::size_t N>
+class Mirror {
+public:
+	/// \effects Map a new anonymous memory file, or allocate a `Buffer` if `N` is not a multiple of the page size
+	Mirror() {
+		if (N % ::sysconf(_SC_PAGESIZE)) {
+			fallback_ = std::make_unique<Buffer<N>>();
+			return;
+		}
+		int fd = ::memfd_create("piex-circular", MFD_CLOEXEC);
+		if (fd < 0) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+		try {
+			if (::ftruncate(fd, N) < 0) {
+				throw std::runtime_error(std::strerror(errno));
+			}
+			map(fd, 0);
+		} catch (...) {
+			::close(fd);
+			throw;
+		}
+		::close(fd);
+	}
+	/// \effects Map `N` bytes of `fd` from `offset`
+	/// \requires `N` and `offset` shall be multiples of the page size
+	Mirror(int fd, off_t offset) {
+		map(fd, offset);
+	}
+	Mirror(const Mirror &) = delete;
+	~Mirror() {
+		if (!fallback_) {
+			::munmap(buf_, 2 * N);
+		}
+	}
+	/// \effects Read from file into circular buffer
+	/// \param fd File descriptor
+	/// \param offset Cursor of the circular buffer
+	/// \param len Size of available space in the circular buffer
+	/// \returns The number of bytes read (the return value of `read`)
+	ssize_t read_from(int fd, std::size_t offset, std::size_t len) {
+		if (fallback_) {
+			return fallback_->read_from(fd, offset, len);
+		}
+		return ::read(fd, buf_ + offset, len);
+	}
+	/// \effects Write from circular buffer into file
+	/// \param fd File descriptor
+	/// \param offset Cursor of the circular buffer
+	/// \param len Size of available data in the circular buffer
+	/// \returns The number of bytes written (the return value of `write`)
+	ssize_t write_to(int fd, std::size_t offset, std::size_t len) {
+		if (fallback_) {
+			return fallback_->write_to(fd, offset, len);
+		}
+		return ::write(fd, buf_ + offset, len);
+	}
+	/// \effects Read from circular buffer into buffer
+	/// \param buf Destination
+	/// \param offset Cursor of the circular buffer
+	/// \param len Size of data to copy
+	void read(void *buf, std::size_t offset, std::size_t len) {
+		if (fallback_) {
+			fallback_->read(buf, offset, len);
+			return;
+		}
+		std::memcpy(buf, buf_ + offset, len);
+	}
+	/// \effects Write from buffer to circular buffer
+	/// \param buf Source
+	/// \param offset Cursor of the circular buffer
+	/// \param len Size of data to copy
+	void write(const void *buf, std::size_t offset, std::size_t len) {
+		if (fallback_) {
+			fallback_->write(buf, offset, len);
+			return;
+		}
+		std::memcpy(buf_ + offset, buf, len);
+	}
+	/// \returns The byte at `offset`. The following `N` bytes are contiguous if `mirrored`, up to the end of the buffer otherwise
+	char *data(std::size_t offset) {
+		return fallback_ ? fallback_->data(offset) : buf_ + offset;
+	}
+	bool mirrored() const {
+		return !fallback_;
+	}
+private:
+	char *buf_ = nullptr;
+	std::unique_ptr<Buffer<N>> fallback_;
+
+	void map(int fd, off_t offset) {
+		if (N % ::sysconf(_SC_PAGESIZE)) {
+			throw std::invalid_argument("mirrored buffer size shall be a multiple of the page size");
+		}
+		// reserve both halves first so that nothing else gets mapped in between
+		void *addr = ::mmap(nullptr, 2 * N, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (addr == MAP_FAILED) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+		buf_ = static_cast<char *>(addr);
+		for (char *half : {buf_, buf_ + N}) {
+			if (::mmap(half, N, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED | MAP_POPULATE, fd, offset) == MAP_FAILED) {
+				int error = errno;
+				::munmap(buf_, 2 * N);
+				throw std::runtime_error(std::strerror(error));
+			}
+		}
+	}
+};
+
 }
 }
 }
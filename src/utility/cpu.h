@@ -0,0 +1,45 @@
+#ifndef PIEX_HEADER_UTILITY_CPU
+#define PIEX_HEADER_UTILITY_CPU
+
+#include <cstdint>
+#include <thread>
+
+namespace piex {
+namespace utility {
+namespace cpu {
+
+/// \effects Hint the processor that the caller is spinning
+inline void relax() {
+#if defined(__aarch64__) || defined(__arm__)
+	asm volatile("yield" ::: "memory");
+#elif defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#else
+	asm volatile("" ::: "memory");
+#endif
+}
+
+/// \remarks Spin with `relax` for `SPINS` rounds, then yield the processor on every round
+template <std::uint32_t SPINS = 1024>
+class Backoff {
+public:
+	void operator()() {
+		if (rounds_ < SPINS) {
+			++rounds_;
+			relax();
+		} else {
+			std::this_thread::yield();
+		}
+	}
+	void reset() {
+		rounds_ = 0;
+	}
+private:
+	std::uint32_t rounds_ = 0;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef PIEX_HEADER_UTILITY_FUTEX
+#define PIEX_HEADER_UTILITY_FUTEX
+
+#include <unistd.h>
+#include <time.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+namespace piex {
+namespace utility {
+namespace futex {
+
+inline int futex(void *uaddr, int futex_op, int val, const timespec *timeout = nullptr) {
+	return syscall(SYS_futex, uaddr, futex_op, val, timeout, NULL, 0);
+}
+
+}
+}
+}
+
+#endif
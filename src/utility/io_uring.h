@@ -0,0 +1,243 @@
+#ifndef PIEX_HEADER_UTILITY_IO_URING
+#define PIEX_HEADER_UTILITY_IO_URING
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace piex {
+namespace utility {
+namespace io_uring {
+
+template <class T>
+T load_acquire(const T *p) {
+	return reinterpret_cast<const std::atomic<T> *>(p)->load(std::memory_order_acquire);
+}
+
+template <class T>
+void store_release(T *p, T value) {
+	reinterpret_cast<std::atomic<T> *>(p)->store(value, std::memory_order_release);
+}
+
+/// \remarks A submission and completion queue pair, set up with raw system calls
+class Ring {
+public:
+	/// \param entries The size of the submission queue
+	/// \param flags `IORING_SETUP_*` flags
+	explicit Ring(unsigned entries, unsigned flags = 0) {
+		io_uring_params params;
+		std::memset(&params, 0, sizeof(params));
+		params.flags = flags;
+		fd_ = ::syscall(__NR_io_uring_setup, entries, &params);
+		if (fd_ < 0) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+		flags_ = flags;
+		sq_size_ = params.sq_off.array + params.sq_entries * sizeof(std::uint32_t);
+		cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		if (params.features & IORING_FEAT_SINGLE_MMAP) {
+			sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+		}
+		sq_ptr_ = map(sq_size_, IORING_OFF_SQ_RING);
+		cq_ptr_ = params.features & IORING_FEAT_SINGLE_MMAP ? sq_ptr_ : map(cq_size_, IORING_OFF_CQ_RING);
+		sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+		sqes_ = static_cast<io_uring_sqe *>(map(sqes_size_, IORING_OFF_SQES));
+
+		char *sq = static_cast<char *>(sq_ptr_);
+		sq_head_ = reinterpret_cast<std::uint32_t *>(sq + params.sq_off.head);
+		sq_tail_ = reinterpret_cast<std::uint32_t *>(sq + params.sq_off.tail);
+		sq_flags_ = reinterpret_cast<std::uint32_t *>(sq + params.sq_off.flags);
+		sq_mask_ = *reinterpret_cast<std::uint32_t *>(sq + params.sq_off.ring_mask);
+		sq_entries_ = params.sq_entries;
+		std::uint32_t *array = reinterpret_cast<std::uint32_t *>(sq + params.sq_off.array);
+		for (std::uint32_t i = 0; i < sq_entries_; ++i) {
+			array[i] = i;
+		}
+		char *cq = static_cast<char *>(cq_ptr_);
+		cq_head_ = reinterpret_cast<std::uint32_t *>(cq + params.cq_off.head);
+		cq_tail_ = reinterpret_cast<std::uint32_t *>(cq + params.cq_off.tail);
+		cq_mask_ = *reinterpret_cast<std::uint32_t *>(cq + params.cq_off.ring_mask);
+		cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+		tail_ = submitted_ = *sq_tail_;
+	}
+	Ring(const Ring &) = delete;
+	~Ring() {
+		::munmap(sqes_, sqes_size_);
+		if (cq_ptr_ != sq_ptr_) {
+			::munmap(cq_ptr_, cq_size_);
+		}
+		::munmap(sq_ptr_, sq_size_);
+		::close(fd_);
+	}
+
+	int fd() const {
+		return fd_;
+	}
+
+	/// \returns A cleared submission queue entry, submitting queued entries first if the queue is full
+	io_uring_sqe *get_sqe() {
+		while (tail_ - load_acquire(sq_head_) >= sq_entries_) {
+			submit(0);
+		}
+		io_uring_sqe *sqe = &sqes_[tail_ & sq_mask_];
+		std::memset(sqe, 0, sizeof(*sqe));
+		++tail_;
+		return sqe;
+	}
+
+	/// \effects Make queued entries visible to the kernel and wait for `wait` completions. Without pending entries and `wait`, no system call is made
+	/// \remarks With `IORING_SETUP_SQPOLL` the kernel thread is only woken up if it went idle
+	void submit(unsigned wait = 0) {
+		store_release(sq_tail_, tail_);
+		unsigned to_submit = tail_ - submitted_;
+		submitted_ = tail_;
+		unsigned flags = wait ? IORING_ENTER_GETEVENTS : 0;
+		if (flags_ & IORING_SETUP_SQPOLL) {
+			if (load_acquire(sq_flags_) & IORING_SQ_NEED_WAKEUP) {
+				flags |= IORING_ENTER_SQ_WAKEUP;
+			}
+			to_submit = 0;
+			if (!flags) {
+				return;
+			}
+		} else if (!to_submit && !wait) {
+			return;
+		}
+		while (::syscall(__NR_io_uring_enter, fd_, to_submit, wait, flags, nullptr, 0) < 0) {
+			if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+				throw std::runtime_error(std::strerror(errno));
+			}
+			to_submit = 0;
+		}
+		++syscalls_;
+	}
+
+	/// \returns The oldest unseen completion, or nullptr if there is none
+	io_uring_cqe *peek() {
+		std::uint32_t head = *cq_head_;
+		if (head == load_acquire(cq_tail_)) {
+			return nullptr;
+		}
+		return &cqes_[head & cq_mask_];
+	}
+
+	/// \effects Release the completion returned by `peek`
+	void seen() {
+		store_release(cq_head_, *cq_head_ + 1);
+	}
+
+	/// \effects Register resources with `IORING_REGISTER_*` opcode
+	void register_resource(unsigned opcode, const void *arg, unsigned nr_args) {
+		if (::syscall(__NR_io_uring_register, fd_, opcode, arg, nr_args) < 0) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+	}
+
+	/// \returns The number of `io_uring_enter` calls made so far
+	std::uint64_t syscalls() const {
+		return syscalls_;
+	}
+private:
+	int fd_;
+	unsigned flags_;
+	std::size_t sq_size_, cq_size_, sqes_size_;
+	void *sq_ptr_, *cq_ptr_;
+	io_uring_sqe *sqes_;
+	std::uint32_t *sq_head_, *sq_tail_, *sq_flags_;
+	std::uint32_t sq_mask_, sq_entries_;
+	std::uint32_t *cq_head_, *cq_tail_;
+	std::uint32_t cq_mask_;
+	io_uring_cqe *cqes_;
+	std::uint32_t tail_, submitted_;
+	std::uint64_t syscalls_ = 0;
+
+	void *map(std::size_t size, off_t offset) {
+		void *ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset);
+		if (ptr == MAP_FAILED) {
+			::close(fd_);
+			throw std::runtime_error(std::strerror(errno));
+		}
+		return ptr;
+	}
+};
+
+/// \remarks A ring of buffers provided to the kernel for buffer selection, e.g. by multishot receive
+class BufferRing {
+public:
+	/// \param ring The io_uring to register with
+	/// \param group The buffer group id
+	/// \param entries The number of buffers, a power of 2
+	/// \param size The size of each buffer
+	BufferRing(Ring &ring, std::uint16_t group, std::uint16_t entries, std::size_t size) :
+		entries_(entries),
+		size_(size) {
+		ring_size_ = entries * sizeof(io_uring_buf);
+		void *ptr = ::mmap(nullptr, ring_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+		if (ptr == MAP_FAILED) {
+			throw std::runtime_error(std::strerror(errno));
+		}
+		ring_ = static_cast<io_uring_buf_ring *>(ptr);
+		data_ = static_cast<char *>(::mmap(nullptr, entries * size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0));
+		if (data_ == MAP_FAILED) {
+			::munmap(ring_, ring_size_);
+			throw std::runtime_error(std::strerror(errno));
+		}
+		io_uring_buf_reg reg;
+		std::memset(&reg, 0, sizeof(reg));
+		reg.ring_addr = reinterpret_cast<std::uint64_t>(ring_);
+		reg.ring_entries = entries;
+		reg.bgid = group;
+		try {
+			ring.register_resource(IORING_REGISTER_PBUF_RING, &reg, 1);
+		} catch (...) {
+			::munmap(data_, entries * size);
+			::munmap(ring_, ring_size_);
+			throw;
+		}
+		for (std::uint16_t i = 0; i < entries; ++i) {
+			recycle(i);
+		}
+	}
+	BufferRing(const BufferRing &) = delete;
+	~BufferRing() {
+		::munmap(data_, entries_ * size_);
+		::munmap(ring_, ring_size_);
+	}
+
+	/// \returns The buffer with id `id`
+	char *buffer(std::uint16_t id) {
+		return data_ + id * size_;
+	}
+
+	/// \effects Hand the buffer with id `id` back to the kernel
+	void recycle(std::uint16_t id) {
+		// `io_uring_buf_ring::bufs` is misplaced in C++ as its flexible array member is preceded by an empty struct
+		io_uring_buf &buf = reinterpret_cast<io_uring_buf *>(ring_)[tail_ & (entries_ - 1)];
+		buf.addr = reinterpret_cast<std::uint64_t>(buffer(id));
+		buf.len = size_;
+		buf.bid = id;
+		++tail_;
+		store_release(&ring_->tail, tail_);
+	}
+private:
+	io_uring_buf_ring *ring_;
+	char *data_;
+	std::size_t ring_size_;
+	std::uint16_t entries_;
+	std::size_t size_;
+	std::uint16_t tail_ = 0;
+};
+
+}
+}
+}
+
+#endif
@@ -1,8 +1,14 @@
 #ifndef PIEX_HEADER_UTILITY_SOCKET
 #define PIEX_HEADER_UTILITY_SOCKET
 
+#include <fcntl.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <netdb.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
 
 namespace piex {
 namespace utility {
@@ -13,6 +19,14 @@ inline int enable_option(int fd, int level, int option_name) {
 	return setsockopt(fd, level, option_name, &on, sizeof(on));
 }
 
+/// \effects Make operations on `fd` fail with `EAGAIN` instead of blocking
+inline void set_nonblocking(int fd) {
+	int flags = ::fcntl(fd, F_GETFL);
+	if (flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+		throw std::runtime_error(std::strerror(errno));
+	}
+}
+
 /// \effects Create a socket that has been bind or connected
 /// \param host The host to connect / bind
 /// \param port The port to connect / bind
@@ -54,6 +68,39 @@ inline int create_socket(const char *host, const char *port, bool is_server) {
 	throw std::runtime_error("getaddrinfo returns no data");
 }
 
+/// \remarks The largest `n` that `Socket::peek` accepts
+constexpr std::size_t PEEK_SIZE = 64;
+
+/// \remarks `peek` and `consume` for sockets that cannot expose their own buffers: peeked bytes are read once into a small staging area
+class Staging {
+public:
+	/// \returns `n` contiguous bytes read from `socket`, or nullptr on end of stream
+	/// \requires `n` shall not be greater than `PEEK_SIZE`
+	template <class Socket>
+	const void *peek(Socket &socket, std::size_t n) {
+		if (size_ < n) {
+			int ret = socket.read(buf_, n, size_);
+			if (ret < static_cast<int>(n)) {
+				return nullptr;
+			}
+			size_ = n;
+		}
+		return buf_;
+	}
+	/// \effects Discard the first `n` peeked bytes
+	void consume(std::size_t n) {
+		size_ -= n;
+		std::memmove(buf_, buf_ + n, size_);
+	}
+	/// \returns The number of bytes peeked but not consumed
+	std::size_t size() const {
+		return size_;
+	}
+private:
+	alignas(std::max_align_t) char buf_[PEEK_SIZE];
+	std::size_t size_ = 0;
+};
+
 }
 }
 }
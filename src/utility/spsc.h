@@ -0,0 +1,344 @@
+#ifndef PIEX_HEADER_UTILITY_SPSC
+#define PIEX_HEADER_UTILITY_SPSC
+
+#include <time.h>
+#include <sys/types.h>
+#include <linux/futex.h>
+#include <cstdint>
+#include <atomic>
+#include "src/utility/circular.h"
+#include "src/utility/cpu.h"
+#include "src/utility/futex.h"
+
+namespace piex {
+namespace utility {
+namespace spsc {
+
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+/// \remarks Bound of the sleeps that are not given a timeout: a `close` (`interrupt`) racing with a side about to sleep does not wake it up, so it is noticed on the next check instead
+constexpr timespec CLOSE_POLL = {0, 100 * 1000 * 1000};
+
+/// \remarks Lock-free ring for one producer thread and one consumer thread. Slots are handed out in place so that elements can be constructed and consumed without copies.
+/// \remarks The published positions are on separate cache lines, and each side keeps a cached copy of the remote position that is only refreshed when the ring looks full (empty).
+/// \remarks Either side may wait for the other with `wait_reserve` (`wait_front`), which spins, then flags itself and sleeps on a futex on the remote position, like `Control`.
+/// \requires `N` shall be a power of 2 not greater than 2^31
+template <class T, std::size_t N>
+class Ring {
+	static_assert(N && (N & (N - 1)) == 0 && N <= (std::size_t(1) << 31), "N shall be a power of 2 not greater than 2^31");
+public:
+	using ValueType = T;
+
+	/// \returns A free slot at the tail, or nullptr if the ring is full
+	/// \remarks May only be called by the producer. The slot is not visible to the consumer before `publish`
+	T *reserve() {
+		std::uint32_t tail = tail_.load(std::memory_order_relaxed);
+		if (tail - head_cache_ == N) {
+			head_cache_ = head_.load(std::memory_order_acquire);
+			if (tail - head_cache_ == N) {
+				return nullptr;
+			}
+		}
+		return &buf_[tail & (N - 1)];
+	}
+	/// \returns A free slot at the tail, waiting for one if the ring is full, or nullptr once `stop` is set
+	/// \param spins The number of checks before sleeping
+	/// \remarks May only be called by the producer
+	T *wait_reserve(std::uint32_t spins, const std::atomic_bool &stop) {
+		return wait(spins, stop, producer_waiting_, head_, [this] { return reserve(); });
+	}
+	/// \effects Make the slot returned by the last `reserve` visible to the consumer
+	/// \remarks May only be called by the producer
+	void publish() {
+		tail_.store(tail_.load(std::memory_order_relaxed) + 1);
+		if (consumer_waiting_.load()) {
+			wake(tail_);
+		}
+	}
+	/// \returns The slot at the head, or nullptr if the ring is empty
+	/// \remarks May only be called by the consumer
+	T *front() {
+		std::uint32_t head = head_.load(std::memory_order_relaxed);
+		if (head == tail_cache_) {
+			tail_cache_ = tail_.load(std::memory_order_acquire);
+			if (head == tail_cache_) {
+				return nullptr;
+			}
+		}
+		return &buf_[head & (N - 1)];
+	}
+	/// \returns The slot at the head, waiting for one if the ring is empty, or nullptr once `stop` is set
+	/// \param spins The number of checks before sleeping
+	/// \remarks May only be called by the consumer
+	T *wait_front(std::uint32_t spins, const std::atomic_bool &stop) {
+		return wait(spins, stop, consumer_waiting_, tail_, [this] { return front(); });
+	}
+	/// \effects Release the slot returned by the last `front` to the producer
+	/// \remarks May only be called by the consumer
+	void pop() {
+		head_.store(head_.load(std::memory_order_relaxed) + 1);
+		if (producer_waiting_.load()) {
+			wake(head_);
+		}
+	}
+	/// \effects Wake up both sides so that their waits see the `stop` flag set before
+	void interrupt() {
+		wake(head_);
+		wake(tail_);
+	}
+	/// \returns The number of published slots not yet popped
+	std::size_t size() const {
+		std::uint32_t head = head_.load(std::memory_order_acquire);
+		return std::uint32_t(tail_.load(std::memory_order_acquire) - head);
+	}
+	bool empty() const {
+		return size() == 0;
+	}
+	static constexpr std::size_t capacity() {
+		return N;
+	}
+private:
+	// written by the consumer
+	alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> head_ = 0;
+	std::uint32_t tail_cache_ = 0;
+	// written by the producer
+	alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> tail_ = 0;
+	std::uint32_t head_cache_ = 0;
+	alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> producer_waiting_ = 0;
+	std::atomic<std::uint32_t> consumer_waiting_ = 0;
+	alignas(CACHE_LINE_SIZE) T buf_[N];
+
+	static void wake(std::atomic<std::uint32_t> &position) {
+		futex::futex(&position, FUTEX_WAKE_PRIVATE, 1);
+	}
+
+	template <class F>
+	T *wait(std::uint32_t spins, const std::atomic_bool &stop, std::atomic<std::uint32_t> &waiting, std::atomic<std::uint32_t> &remote, const F &available) {
+		T *slot = available();
+		for (std::uint32_t i = 0; i < spins && !slot && !stop; ++i) {
+			cpu::relax();
+			slot = available();
+		}
+		while (!slot && !stop) {
+			waiting.store(1);
+			std::uint32_t position = remote.load();
+			slot = available();
+			if (!slot && !stop) {
+				futex::futex(&remote, FUTEX_WAIT_PRIVATE, position, &CLOSE_POLL);
+			}
+			waiting.store(0);
+			slot = available();
+		}
+		return slot;
+	}
+};
+
+/// \remarks Positions of a lock-free byte ring for one producer and one consumer, which may sleep while the ring is full (empty). The bytes are kept elsewhere, see `Buffer`.
+/// \remarks Positions are free-running 32-bit counters. The published positions are on separate cache lines, away from the private state of each side: the position not yet published and a cached copy of the remote position. Data is published in batches by `publish` and space in batches by `release`.
+/// \remarks A waiting side spins, then flags itself and sleeps on a futex on the remote position; the other side only wakes it up if the flag is set. A zero-filled object is a valid empty ring, so it may be placed in memory shared between processes if `SHARED` is set.
+/// \requires `N` shall be a power of 2 not greater than 2^31
+template <std::size_t N, bool SHARED = false>
+class Control {
+	static_assert(N && (N & (N - 1)) == 0 && N <= (std::size_t(1) << 31), "N shall be a power of 2 not greater than 2^31");
+public:
+	/// \returns The number of bytes that may be written, or at least `n` if as many are free
+	/// \remarks May only be called by the producer
+	std::size_t writable(std::size_t n = 1) {
+		std::size_t size = N - (producer_.position - producer_.remote);
+		if (size < n) {
+			producer_.remote = head_.load(std::memory_order_acquire);
+			size = N - (producer_.position - producer_.remote);
+		}
+		return size;
+	}
+	/// \returns The offset in the ring of the next byte to write
+	std::size_t write_offset() const {
+		return producer_.position & (N - 1);
+	}
+	/// \effects Mark `n` bytes as written without publishing them
+	/// \requires `n` shall not be greater than `writable()`
+	void produce(std::size_t n) {
+		producer_.position += n;
+	}
+	/// \returns The number of bytes written but not yet published
+	std::size_t unpublished() const {
+		return producer_.position - tail_.load(std::memory_order_relaxed);
+	}
+	/// \effects Make written bytes visible to the consumer
+	/// \returns The number of bytes published
+	std::size_t publish() {
+		std::size_t n = unpublished();
+		if (n) {
+			tail_.store(producer_.position);
+			if (consumer_waiting_.load()) {
+				wake(tail_);
+			}
+		}
+		return n;
+	}
+	/// \effects Publish written bytes and wait until `n` bytes are free or the ring is closed
+	/// \param spins The number of checks before sleeping
+	/// \param timeout Stop waiting after a sleep of this duration
+	/// \returns The number of bytes that may be written, which is less than `n` if the ring is closed or timed out
+	std::size_t wait_writable(std::size_t n, std::uint32_t spins = 0, const timespec *timeout = nullptr) {
+		publish();
+		return wait(n, spins, timeout, producer_waiting_, head_, [this, n] { return writable(n); });
+	}
+
+	/// \returns The number of bytes that may be read, or at least `n` if as many are published
+	/// \remarks May only be called by the consumer
+	std::size_t readable(std::size_t n = 1) {
+		std::size_t size = consumer_.remote - consumer_.position;
+		if (size < n) {
+			consumer_.remote = tail_.load(std::memory_order_acquire);
+			size = consumer_.remote - consumer_.position;
+		}
+		return size;
+	}
+	/// \returns The offset in the ring of the next byte to read
+	std::size_t read_offset() const {
+		return consumer_.position & (N - 1);
+	}
+	/// \effects Mark `n` bytes as read without releasing the space
+	/// \requires `n` shall not be greater than `readable()`
+	void consume(std::size_t n) {
+		consumer_.position += n;
+	}
+	/// \returns The number of bytes read but not yet released
+	std::size_t unreleased() const {
+		return consumer_.position - head_.load(std::memory_order_relaxed);
+	}
+	/// \effects Make read bytes available to the producer
+	/// \returns The number of bytes released
+	std::size_t release() {
+		std::size_t n = unreleased();
+		if (n) {
+			head_.store(consumer_.position);
+			if (producer_waiting_.load()) {
+				wake(head_);
+			}
+		}
+		return n;
+	}
+	/// \effects Release read bytes and wait until `n` bytes are published or the ring is closed
+	/// \param spins The number of checks before sleeping
+	/// \param timeout Stop waiting after a sleep of this duration
+	/// \returns The number of bytes that may be read, which is less than `n` if the ring is closed or timed out
+	std::size_t wait_readable(std::size_t n, std::uint32_t spins = 0, const timespec *timeout = nullptr) {
+		release();
+		return wait(n, spins, timeout, consumer_waiting_, tail_, [this, n] { return readable(n); });
+	}
+
+	/// \effects Wake up both sides and make waits return
+	void close() {
+		closed_.store(1);
+		wake(head_);
+		wake(tail_);
+	}
+	bool closed() const {
+		return closed_.load();
+	}
+private:
+	struct Side {
+		std::uint32_t position;
+		// cached position of the other side
+		std::uint32_t remote;
+	};
+
+	// written by the consumer
+	alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> head_ = 0;
+	// written by the producer
+	alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> tail_ = 0;
+	alignas(CACHE_LINE_SIZE) Side producer_ = {0, 0};
+	alignas(CACHE_LINE_SIZE) Side consumer_ = {0, 0};
+	alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> producer_waiting_ = 0;
+	std::atomic<std::uint32_t> consumer_waiting_ = 0;
+	std::atomic<std::uint32_t> closed_ = 0;
+
+	static constexpr int WAIT_OPERATION = SHARED ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE;
+	static constexpr int WAKE_OPERATION = SHARED ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE;
+
+	static void wake(std::atomic<std::uint32_t> &position) {
+		futex::futex(&position, WAKE_OPERATION, 1);
+	}
+
+	template <class F>
+	std::size_t wait(std::size_t n, std::uint32_t spins, const timespec *timeout, std::atomic<std::uint32_t> &waiting, std::atomic<std::uint32_t> &remote, const F &available) {
+		std::size_t size = available();
+		for (std::uint32_t i = 0; i < spins && size < n && !closed(); ++i) {
+			cpu::relax();
+			size = available();
+		}
+		while (size < n && !closed()) {
+			waiting.store(1);
+			std::uint32_t position = remote.load();
+			size = available();
+			if (size < n && !closed()) {
+				futex::futex(&remote, WAIT_OPERATION, position, timeout ? timeout : &CLOSE_POLL);
+			}
+			waiting.store(0);
+			size = available();
+			if (timeout) {
+				break;
+			}
+		}
+		return size;
+	}
+};
+
+/// \remarks Lock-free byte ring for one producer thread and one consumer thread, see `Control`
+/// \remarks With a mirrored `circular::Mirror` storage, the bytes returned by `readable` (`writable`) are contiguous from `front` (`back`) and may be accessed in place. Otherwise they are contiguous up to the end of the ring only, see `contiguous`
+template <std::size_t N, class Storage = circular::Buffer<N>>
+class Buffer : public Control<N> {
+public:
+	/// \effects Copy `n` bytes from `buf` into the ring without publishing them
+	/// \requires `n` shall not be greater than `writable()`
+	void write(const void *buf, std::size_t n) {
+		buffer_.write(buf, this->write_offset(), n);
+		this->produce(n);
+	}
+	/// \effects Read at most `n` bytes from `fd` into the ring without publishing them
+	/// \returns The return value of `read` or `readv`
+	ssize_t read_from(int fd, std::size_t n) {
+		ssize_t ret = buffer_.read_from(fd, this->write_offset(), n);
+		if (ret > 0) {
+			this->produce(ret);
+		}
+		return ret;
+	}
+	/// \effects Copy `n` bytes from the ring to `buf` without releasing the space
+	/// \requires `n` shall not be greater than `readable()`
+	void read(void *buf, std::size_t n) {
+		buffer_.read(buf, this->read_offset(), n);
+		this->consume(n);
+	}
+	/// \effects Write at most `n` bytes from the ring to `fd` without releasing the space
+	/// \returns The return value of `write` or `writev`
+	ssize_t write_to(int fd, std::size_t n) {
+		ssize_t ret = buffer_.write_to(fd, this->read_offset(), n);
+		if (ret > 0) {
+			this->consume(ret);
+		}
+		return ret;
+	}
+	/// \returns The next byte to read
+	const char *front() {
+		return buffer_.data(this->read_offset());
+	}
+	/// \returns The next byte to write
+	char *back() {
+		return buffer_.data(this->write_offset());
+	}
+	/// \returns Whether the next `n` bytes to read are contiguous from `front`
+	bool contiguous(std::size_t n) const {
+		return buffer_.mirrored() || this->read_offset() + n <= N;
+	}
+private:
+	alignas(CACHE_LINE_SIZE) Storage buffer_;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,315 @@
+#ifndef PIEX_HEADER_UTILITY_THREAD
+#define PIEX_HEADER_UTILITY_THREAD
+
+#include <pthread.h>
+#include <sched.h>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <thread>
+#include <utility>
+#include <algorithm>
+
+namespace piex {
+namespace utility {
+namespace thread {
+
+/// \effects Restrict `thread` to run on `cpu` only
+/// \param thread The thread to pin
+/// \param cpu The cpu index. Negative values leave the placement to the scheduler
+inline void pin(pthread_t thread, int cpu) {
+	if (cpu < 0) {
+		return;
+	}
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	int ret = pthread_setaffinity_np(thread, sizeof(set), &set);
+	if (ret) {
+		throw std::runtime_error(std::strerror(ret));
+	}
+}
+
+/// \remarks The cpus the process was allowed to run on when it started, read during static initialization, before any thread is pinned. All cpus if unavailable
+inline const cpu_set_t INITIAL_CPUS = [] {
+	cpu_set_t set;
+	if (sched_getaffinity(0, sizeof(set), &set)) {
+		CPU_ZERO(&set);
+		for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+			CPU_SET(cpu, &set);
+		}
+	}
+	return set;
+}();
+
+/// \effects Run `thread` under `SCHED_FIFO` at `priority`
+/// \param priority The real-time priority, from 1 to 99. 0 leaves the policy unchanged
+/// \remarks Requires `CAP_SYS_NICE` or a sufficient `RLIMIT_RTPRIO`
+inline void prioritize(pthread_t thread, int priority) {
+	if (priority <= 0) {
+		return;
+	}
+	sched_param param;
+	std::memset(&param, 0, sizeof(param));
+	param.sched_priority = priority;
+	int ret = pthread_setschedparam(thread, SCHED_FIFO, &param);
+	if (ret) {
+		throw std::runtime_error(std::strerror(ret));
+	}
+}
+
+/// \remarks Where and how a thread runs. The defaults leave both to the scheduler
+struct Placement {
+	int cpu = -1;
+	int priority = 0;
+};
+
+inline void place(pthread_t thread, const Placement &placement) {
+	pin(thread, placement.cpu);
+	prioritize(thread, placement.priority);
+}
+
+/// \returns A new thread running `f(args...)` under `placement`
+/// \remarks The thread inherits the placement from the caller, which is placed temporarily: a placement that cannot be applied throws before the thread is started. A thread left to the scheduler may run on any of `INITIAL_CPUS` under the default policy, whatever the caller is pinned to
+template <class Function, class... Args>
+std::thread spawn(const Placement &placement, Function &&f, Args &&...args) {
+	pthread_t self = pthread_self();
+	cpu_set_t set;
+	int policy;
+	sched_param param;
+	if (pthread_getaffinity_np(self, sizeof(set), &set) || pthread_getschedparam(self, &policy, &param)) {
+		throw std::runtime_error("cannot read the placement of the current thread");
+	}
+	auto restore = [&] {
+		pthread_setaffinity_np(self, sizeof(set), &set);
+		pthread_setschedparam(self, policy, &param);
+	};
+	try {
+		if (placement.cpu < 0) {
+			int ret = pthread_setaffinity_np(self, sizeof(cpu_set_t), &INITIAL_CPUS);
+			if (ret) {
+				throw std::runtime_error(std::strerror(ret));
+			}
+		}
+		if (placement.priority <= 0 && policy != SCHED_OTHER) {
+			sched_param other;
+			std::memset(&other, 0, sizeof(other));
+			int ret = pthread_setschedparam(self, SCHED_OTHER, &other);
+			if (ret) {
+				throw std::runtime_error(std::strerror(ret));
+			}
+		}
+		place(self, placement);
+		std::thread thread(std::forward<Function>(f), std::forward<Args>(args)...);
+		restore();
+		return thread;
+	} catch (...) {
+		restore();
+		throw;
+	}
+}
+
+/// \remarks Placements of the threads on the request path: the matching thread, which also reads and writes the socket in most servers, and the reader and writer daemons of the multithreaded sockets
+struct Affinity {
+	Placement matching;
+	Placement reader;
+	Placement writer;
+};
+
+struct Cpu {
+	int id;
+	int package;
+	int core;
+	bool isolated;
+};
+
+/// \returns The cpus in a list such as `0-2,5`
+inline std::vector<int> parse_list(const std::string &list) {
+	std::vector<int> cpus;
+	std::size_t begin = 0;
+	while (begin < list.size()) {
+		std::size_t end = list.find(',', begin);
+		if (end == std::string::npos) {
+			end = list.size();
+		}
+		std::string range = list.substr(begin, end - begin);
+		std::size_t dash = range.find('-');
+		if (!range.empty() && range.find_first_not_of("0123456789-\n") == std::string::npos) {
+			int first = std::atoi(range.c_str());
+			int last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+			for (int cpu = first; cpu <= last; ++cpu) {
+				cpus.push_back(cpu);
+			}
+		}
+		begin = end + 1;
+	}
+	return cpus;
+}
+
+/// \returns The online cpus described under `root`, the sysfs cpu directory. Empty if unavailable
+inline std::vector<Cpu> topology(const std::string &root = "/sys/devices/system/cpu") {
+	auto read = [](const std::string &path) {
+		std::ifstream file(path);
+		std::string line;
+		std::getline(file, line);
+		return line;
+	};
+	std::vector<int> isolated = parse_list(read(root + "/isolated"));
+	std::vector<Cpu> cpus;
+	for (int id : parse_list(read(root + "/online"))) {
+		std::string prefix = root + "/cpu" + std::to_string(id) + "/topology/";
+		std::string package = read(prefix + "physical_package_id");
+		std::string core = read(prefix + "core_id");
+		cpus.push_back({
+			id,
+			package.empty() ? 0 : std::atoi(package.c_str()),
+			core.empty() ? id : std::atoi(core.c_str()),
+			std::find(isolated.begin(), isolated.end(), id) != isolated.end(),
+		});
+	}
+	return cpus;
+}
+
+/// \returns Placements for `cpus`: the matching thread on an isolated cpu, or the last one, and the daemons on neighbouring cores of the same package, away from cpu 0 which usually serves interrupts
+/// \remarks Hardware threads of the core of the matching thread are avoided. Nothing is pinned on a single cpu
+inline Affinity defaults(const std::vector<Cpu> &cpus) {
+	Affinity affinity;
+	if (cpus.size() < 2) {
+		return affinity;
+	}
+	auto matching = std::find_if(cpus.begin(), cpus.end(), [](const Cpu &cpu) { return cpu.isolated; });
+	if (matching == cpus.end()) {
+		matching = cpus.end() - 1;
+	}
+	affinity.matching.cpu = matching->id;
+	std::vector<Cpu> others;
+	for (const Cpu &cpu : cpus) {
+		if (cpu.package != matching->package || cpu.core != matching->core) {
+			others.push_back(cpu);
+		}
+	}
+	if (others.empty()) {
+		return affinity;
+	}
+	// same package first, then other cores before hardware threads of a core already taken, highest ids first
+	std::sort(others.begin(), others.end(), [&](const Cpu &a, const Cpu &b) {
+		if ((a.package == matching->package) != (b.package == matching->package)) {
+			return a.package == matching->package;
+		}
+		if (a.isolated != b.isolated) {
+			return !a.isolated;
+		}
+		return a.id > b.id;
+	});
+	affinity.reader.cpu = others[0].id;
+	auto writer = std::find_if(others.begin() + 1, others.end(), [&](const Cpu &cpu) {
+		return cpu.package != others[0].package || cpu.core != others[0].core;
+	});
+	affinity.writer.cpu = writer != others.end() ? writer->id : others.size() > 1 ? others[1].id : others[0].id;
+	return affinity;
+}
+
+/// \returns The placements described by `spec`, a comma-separated list of `auto`, which starts from `defaults(cpus)`, and `role=cpu[:priority]` entries, where `role` is `matching`, `reader` or `writer` and a cpu of -1 leaves the placement to the scheduler
+/// \remarks Cpus not in `cpus` are rejected unless it is empty
+inline Affinity parse(const std::string &spec, const std::vector<Cpu> &cpus) {
+	Affinity affinity;
+	std::size_t begin = 0;
+	while (begin < spec.size()) {
+		std::size_t end = spec.find(',', begin);
+		if (end == std::string::npos) {
+			end = spec.size();
+		}
+		std::string entry = spec.substr(begin, end - begin);
+		begin = end + 1;
+		if (entry.empty()) {
+			continue;
+		}
+		if (entry == "auto") {
+			affinity = defaults(cpus);
+			continue;
+		}
+		std::size_t equal = entry.find('=');
+		if (equal == std::string::npos) {
+			throw std::runtime_error("invalid affinity entry: " + entry);
+		}
+		std::string role = entry.substr(0, equal);
+		Placement *placement =
+			role == "matching" ? &affinity.matching :
+			role == "reader" ? &affinity.reader :
+			role == "writer" ? &affinity.writer :
+			nullptr;
+		if (!placement) {
+			throw std::runtime_error("invalid affinity role: " + role);
+		}
+		const char *value = entry.c_str() + equal + 1;
+		char *rest;
+		placement->cpu = std::strtol(value, &rest, 10);
+		bool valid = rest != value;
+		placement->priority = 0;
+		if (*rest == ':') {
+			value = rest + 1;
+			placement->priority = std::strtol(value, &rest, 10);
+			valid = valid && rest != value;
+		}
+		if (!valid || *rest) {
+			throw std::runtime_error("invalid affinity entry: " + entry);
+		}
+		// rejected here rather than by the first thread placed, so that a partially started pipeline need not be unwound
+		if (placement->cpu >= 0 && !cpus.empty() && std::none_of(cpus.begin(), cpus.end(), [&](const Cpu &cpu) { return cpu.id == placement->cpu; })) {
+			throw std::runtime_error("cpu not online: " + entry);
+		}
+	}
+	return affinity;
+}
+
+/// \returns `n` placements like `first`: the first on the cpu of `first`, the others on the next cpus of `cpus` by id, wrapping around and skipping `taken`
+/// \remarks Nothing is pinned if `first` is not. Cpus 0 to `std::thread::hardware_concurrency() - 1` are assumed if `cpus` is empty. Throws if the cpu of `first` is not among them, or if they are too few, so that the placements are known valid before any thread starts
+inline std::vector<Placement> spread(const Placement &first, std::size_t n, const std::vector<int> &taken, const std::vector<Cpu> &cpus) {
+	std::vector<Placement> placements(n, first);
+	if (first.cpu < 0) {
+		return placements;
+	}
+	std::vector<int> ids;
+	for (const Cpu &cpu : cpus) {
+		ids.push_back(cpu.id);
+	}
+	if (ids.empty()) {
+		for (int cpu = 0; cpu < static_cast<int>(std::thread::hardware_concurrency()); ++cpu) {
+			ids.push_back(cpu);
+		}
+	}
+	std::sort(ids.begin(), ids.end());
+	auto start = std::find(ids.begin(), ids.end(), first.cpu);
+	if (start == ids.end()) {
+		throw std::runtime_error("cpu not online: " + std::to_string(first.cpu));
+	}
+	std::rotate(ids.begin(), start, ids.end());
+	std::size_t i = 1;
+	for (auto it = ids.begin() + 1; it != ids.end() && i < n; ++it) {
+		if (std::find(taken.begin(), taken.end(), *it) == taken.end()) {
+			placements[i++].cpu = *it;
+		}
+	}
+	if (i < n) {
+		throw std::runtime_error("not enough cpus for " + std::to_string(n) + " threads from cpu " + std::to_string(first.cpu));
+	}
+	return placements;
+}
+
+/// \returns The placements configured by the `PIEX_AFFINITY` environment variable, see `parse`. Leaves everything to the scheduler if it is unset
+inline const Affinity &affinity() {
+	static const Affinity affinity = [] {
+		const char *spec = std::getenv("PIEX_AFFINITY");
+		return spec ? parse(spec, topology()) : Affinity();
+	}();
+	return affinity;
+}
+
+}
+}
+}
+
+#endif
@@ -4,6 +4,7 @@
 #include "gmock/gmock.h"
 #include "tests/config_override.h"
 #include "src/exchange/exchange.h"
+#include "src/exchange/market.h"
 #include "src/packets/packets.h"
 
 class Exchange : public testing::Test {
@@ -87,3 +88,41 @@ TEST_F(Exchange, mixed) {
 		piex::Response::Place(true, 4)
 	}));
 }
+
+TEST_F(Exchange, instrument) {
+	piex::Exchange<Exchange> other(*this, 7);
+	other.process_request({piex::Request::SELL, 0, 100, 1, 7});
+	other.process_request({piex::Request::BUY, 1, 100, 2, 7});
+	other.process_request({piex::Request::BUY, 1, 7});
+
+	ASSERT_THAT(responses, testing::ElementsAre(
+		piex::Response::Place(true, 0, 7),
+		piex::Response::Match(1, 0, 100, 1, 100, 0, 7),
+		piex::Response::Place(true, 1, 7),
+		piex::Response::Cancel(true, 1, 7)
+	));
+}
+
+class Market : public Exchange {
+protected:
+	piex::Market<Exchange> market{*this};
+};
+
+TEST_F(Market, route) {
+	market.process_request(piex::Request::Place{piex::Request::SELL, 0, 100, 1, 3});
+	market.process_request(piex::Request::Place{piex::Request::BUY, 1, 100, 1, 5});
+	market.process_request(piex::Request::Place{piex::Request::BUY, 2, 100, 1, 3});
+	market.process_request(piex::Request::Cancel{piex::Request::BUY, 1, 3});
+	market.process_request(piex::Request::Cancel{piex::Request::BUY, 1, 5});
+
+	ASSERT_THAT(responses, testing::ElementsAre(
+		piex::Response::Place(true, 0, 3),
+		piex::Response::Place(true, 1, 5),
+		piex::Response::Match(2, 0, 100, 1, 0, 0, 3),
+		piex::Response::Place(true, 2, 3),
+		piex::Response::Cancel(false, 1, 3),
+		piex::Response::Cancel(true, 1, 5)
+	));
+	EXPECT_EQ(market.active_instruments(), 2);
+	EXPECT_EQ(market.sequence(), 5);
+}
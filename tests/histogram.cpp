@@ -0,0 +1,55 @@
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include "gtest/gtest.h"
+#include "benchmark/histogram.h"
+
+using piex::benchmark::Histogram;
+
+TEST(Histogram, empty) {
+	Histogram histogram;
+	ASSERT_EQ(histogram.count(), 0);
+	ASSERT_EQ(histogram.value_at_percentile(50), 0);
+	ASSERT_EQ(histogram.max(), 0);
+}
+
+TEST(Histogram, exact_small_values) {
+	Histogram histogram(3);
+	for (std::uint64_t i = 0; i < 1000; ++i) {
+		histogram.record(i);
+	}
+	ASSERT_EQ(histogram.min(), 0);
+	ASSERT_EQ(histogram.max(), 999);
+	ASSERT_EQ(histogram.value_at_percentile(50), 499);
+	ASSERT_EQ(histogram.value_at_percentile(100), 999);
+	ASSERT_DOUBLE_EQ(histogram.mean(), 499.5);
+}
+
+TEST(Histogram, precision) {
+	Histogram histogram(3);
+	std::vector<std::uint64_t> values;
+	// from nanoseconds to seconds
+	for (std::uint64_t value = 1; value < 4000000000; value = value * 3 / 2 + 1) {
+		values.push_back(value);
+		histogram.record(value);
+	}
+	for (double percentile : {10.0, 50.0, 90.0, 99.0, 99.9999}) {
+		std::uint64_t expected = values[static_cast<std::size_t>(std::ceil(percentile / 100 * values.size())) - 1];
+		std::uint64_t actual = histogram.value_at_percentile(percentile);
+		ASSERT_LE(std::abs(static_cast<double>(actual) - expected), expected * 1e-3);
+	}
+	ASSERT_EQ(histogram.max(), values.back());
+}
+
+TEST(Histogram, merge) {
+	Histogram a(2), b(2);
+	a.record(5, 3);
+	b.record(700000);
+	a.merge(b);
+	ASSERT_EQ(a.count(), 4);
+	ASSERT_EQ(a.value_at_percentile(75), 5);
+	ASSERT_EQ(a.value_at_percentile(100), 700000);
+	ASSERT_EQ(a.min(), 5);
+	ASSERT_THROW(a.merge(Histogram(3)), std::invalid_argument);
+}
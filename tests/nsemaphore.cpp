@@ -0,0 +1,80 @@
+#include <unistd.h>
+#include <poll.h>
+#include <cstdint>
+#include <chrono>
+#include <thread>
+#include "gtest/gtest.h"
+#include "tests/config_override.h"
+
+#ifdef PIEX_OPTION_NSEMAPHORE
+#include "src/nsemaphore/nsemaphore.h"
+
+TEST(NSemaphore, strict) {
+	piex::nsemaphore::Strict semaphore(0);
+	std::thread poster([&] {
+		for (int i = 0; i < 4; ++i) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			semaphore.post(2);
+		}
+	});
+	semaphore.wait(8);
+	ASSERT_EQ(semaphore.load(), 8);
+	semaphore.consume(8);
+	ASSERT_EQ(semaphore.load(), 0);
+	poster.join();
+}
+
+TEST(NSemaphore, loose_flush) {
+	piex::nsemaphore::Loose semaphore(0);
+	std::thread poster([&] {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		semaphore.post(3);
+		semaphore.flush();
+	});
+	semaphore.wait(8);
+	ASSERT_EQ(semaphore.load(), 3);
+	semaphore.consume(3);
+	poster.join();
+}
+
+TEST(NSemaphore, statistics) {
+	piex::nsemaphore::Strict semaphore(0);
+	// the poster sleeps far longer than any spin budget
+	std::thread poster([&] {
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		semaphore.post(1);
+	});
+	semaphore.wait(1);
+	poster.join();
+	piex::nsemaphore::Statistics statistics = semaphore.statistics();
+	ASSERT_EQ(statistics.parks, 1);
+	ASSERT_EQ(statistics.spins, 0);
+	ASSERT_LE(statistics.budget, piex::nsemaphore::MAX_SPINS);
+	if (piex::nsemaphore::MAX_SPINS > 0 && std::thread::hardware_concurrency() > 1) {
+		// a long park halves the budget
+		ASSERT_EQ(statistics.budget, piex::nsemaphore::MAX_SPINS / 2);
+	}
+}
+#if PIEX_OPTION_NSEMAPHORE == PIEX_OPTION_NSEMAPHORE_EVENTFD
+TEST(NSemaphore, fd) {
+	piex::nsemaphore::Strict semaphore(0);
+	pollfd fds = {semaphore.fd(), POLLIN, 0};
+	ASSERT_FALSE(semaphore.arm(4));
+	// posts below the armed size are not signaled
+	semaphore.post(3);
+	ASSERT_EQ(::poll(&fds, 1, 0), 0);
+	semaphore.post(1);
+	ASSERT_EQ(::poll(&fds, 1, 0), 1);
+	// only the post crossing the armed size writes
+	semaphore.post(1);
+	std::uint64_t writes;
+	ASSERT_EQ(::read(semaphore.fd(), &writes, sizeof(writes)), sizeof(writes));
+	ASSERT_EQ(writes, 1);
+	semaphore.disarm();
+	ASSERT_EQ(::poll(&fds, 1, 0), 0);
+	ASSERT_TRUE(semaphore.arm(5));
+	semaphore.disarm();
+	semaphore.consume(5);
+}
+#endif
+#endif
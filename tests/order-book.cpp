@@ -1,4 +1,7 @@
+#include <vector>
+#include <iterator>
 #include "gtest/gtest.h"
+#include "gmock/gmock.h"
 #include "tests/config_override.h"
 #include "src/order-book/order-book.h"
 #include "src/order/order.h"
@@ -107,3 +110,22 @@ TEST_F(OrderBook, remove) {
 	ASSERT_EQ(buys.size(), 0);
 	ASSERT_TRUE(buys.empty());
 }
+
+TEST_F(OrderBook, load) {
+	const piex::BuyOrder orders[] = {{1, 20, 1}, {5, 20, 2}, {0, 10, 3}, {2, 10, 4}};
+	buys.insert({9, 30, 1});
+	buys.load(std::begin(orders), std::end(orders));
+	ASSERT_EQ(buys.size(), 4);
+	std::vector<piex::BuyOrder> dumped;
+	buys.for_each([&dumped](const piex::BuyOrder &order) {
+		dumped.push_back(order);
+	});
+	EXPECT_THAT(dumped, testing::ElementsAreArray(orders));
+	EXPECT_EQ(buys.top().id(), 1);
+	buys.pop();
+	EXPECT_EQ(buys.top().id(), 5);
+	EXPECT_TRUE(buys.remove(0));
+	buys.pop();
+	EXPECT_EQ(buys.top().id(), 2);
+	EXPECT_FALSE(buys.remove(9));
+}
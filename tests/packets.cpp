@@ -76,3 +76,35 @@ TEST_F(Response, match_reinterpret) {
 	piex::Response::Match &reinterpreted_response = buf.data().match;
 	EXPECT_EQ(reinterpreted_response, response);
 }
+
+TEST_F(Request, place_instrument) {
+	piex::Request::Place request(piex::Request::SELL, 111, 222, 333, 444);
+	reinterpret_header(request);
+	reinterpret_body(request);
+	piex::Request::Place &reinterpreted_request = buf.data().place;
+	EXPECT_EQ(reinterpreted_request.instrument(), 444);
+	EXPECT_EQ(reinterpreted_request.order_type(), piex::Request::SELL);
+	EXPECT_EQ(reinterpreted_request.order().id(), 111);
+	EXPECT_FALSE(reinterpreted_request == piex::Request::Place(piex::Request::SELL, 111, 222, 333, 445));
+}
+
+TEST_F(Request, cancel_instrument) {
+	piex::Request::Cancel request(piex::Request::BUY, 111, 65535);
+	reinterpret_header(request);
+	reinterpret_body(request);
+	piex::Request::Cancel &reinterpreted_request = buf.data().cancel;
+	EXPECT_EQ(reinterpreted_request.instrument(), 65535);
+	EXPECT_EQ(reinterpreted_request.order_type(), piex::Request::BUY);
+	EXPECT_EQ(reinterpreted_request.id(), 111);
+}
+
+TEST_F(Response, match_instrument) {
+	piex::Response::Match response(999, 888, 777, 666, 555, 444, 333);
+	reinterpret_header(response);
+	EXPECT_EQ(buf.data().header.type(), piex::Response::MATCH);
+	reinterpret_body(response);
+	piex::Response::Match &reinterpreted_response = buf.data().match;
+	EXPECT_EQ(reinterpreted_response.instrument(), 333);
+	EXPECT_EQ(reinterpreted_response.buy_id(), 999);
+	EXPECT_FALSE(reinterpreted_response == piex::Response::Match(999, 888, 777, 666, 555, 444, 332));
+}
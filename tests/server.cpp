@@ -102,3 +102,100 @@ TEST_F(Server, cancel) {
 	));
 }
 
+TEST_F(Server, instrument) {
+	client.sell({0, 100, 1}, 1);
+	client.buy({1, 100, 1}, 2);
+	client.buy({2, 100, 1}, 1);
+	client.cancel_buy(1, 2);
+	client.flush();
+	wait();
+	client.try_receive_responses();
+
+	ASSERT_THAT(responses, testing::ElementsAre(
+		piex::Response::Place(true, 0, 1),
+		piex::Response::Place(true, 1, 2),
+		piex::Response::Match(2, 0, 100, 1, 0, 0, 1),
+		piex::Response::Place(true, 2, 1),
+		piex::Response::Cancel(true, 1, 2)
+	));
+}
+
+#if PIEX_OPTION_SERVER_IMPLICIT_FLUSH
+TEST_F(Server, implicit_flush) {
+	client.buy({0, 100, 1});
+	client.sell({1, 200, 1});
+	client.send();
+	wait();
+	client.try_receive_responses();
+
+	ASSERT_THAT(responses, testing::ElementsAre(
+		piex::Response::Place(true, 0),
+		piex::Response::Place(true, 1)
+	));
+}
+#endif
+
+#if PIEX_OPTION_SERVER == PIEX_OPTION_SERVER_EPOLL
+struct Counterparty {
+	void on_place(const piex::Response::Place &response) {
+		responses.emplace_back(response);
+	}
+	void on_cancel(const piex::Response::Cancel &response) {
+		responses.emplace_back(response);
+	}
+	void on_match(const piex::Response::Match &response) {
+		responses.emplace_back(response);
+	}
+	std::vector<std::variant<piex::Response::Place, piex::Response::Cancel, piex::Response::Match>> responses;
+};
+
+TEST_F(Server, counterparty) {
+	Counterparty other;
+	piex::Client<Counterparty> other_client(other);
+	other_client.connect("127.0.0.1", "3000");
+	other_client.sell({0, 100, 2});
+	other_client.flush();
+	wait();
+	client.buy({1, 100, 1});
+	client.flush();
+	wait();
+	client.try_receive_responses();
+	other_client.try_receive_responses();
+	other_client.close();
+
+	ASSERT_THAT(responses, testing::ElementsAre(
+		piex::Response::Match(1, 0, 100, 1, 0, 100),
+		piex::Response::Place(true, 1)
+	));
+	ASSERT_THAT(other.responses, testing::ElementsAre(
+		piex::Response::Place(true, 0),
+		piex::Response::Match(1, 0, 100, 1, 0, 100)
+	));
+}
+
+TEST_F(Server, ownership) {
+	Counterparty other;
+	piex::Client<Counterparty> other_client(other);
+	other_client.connect("127.0.0.1", "3000");
+	other_client.sell({0, 100, 1});
+	other_client.sell({1, 100, 1});
+	other_client.flush();
+	wait();
+	// only the owner may cancel an order, until it disconnects
+	client.cancel_sell(0);
+	client.flush();
+	wait();
+	other_client.try_receive_responses();
+	other_client.close();
+	wait();
+	client.cancel_sell(1);
+	client.flush();
+	wait();
+	client.try_receive_responses();
+
+	ASSERT_THAT(responses, testing::ElementsAre(
+		piex::Response::Cancel(false, 0),
+		piex::Response::Cancel(true, 1)
+	));
+}
+#endif
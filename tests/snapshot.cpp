@@ -0,0 +1,116 @@
+#include <unistd.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <variant>
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "tests/config_override.h"
+#include "src/exchange/exchange.h"
+#include "src/exchange/market.h"
+#include "src/packets/packets.h"
+
+class Snapshot : public testing::Test {
+public:
+	Snapshot() : exchange(*this), restored(*this) {}
+	void on_place(const piex::Response::Place &response) {
+		responses.emplace_back(response);
+	}
+	void on_cancel(const piex::Response::Cancel &response) {
+		responses.emplace_back(response);
+	}
+	void on_match(const piex::Response::Match &response) {
+		responses.emplace_back(response);
+	}
+protected:
+	piex::Exchange<Snapshot> exchange, restored;
+	std::vector<std::variant<piex::Response::Place, piex::Response::Cancel, piex::Response::Match>> responses;
+	std::string path = "/tmp/piex-snapshot-" + std::to_string(::getpid());
+	virtual void TearDown() {
+		std::remove(path.c_str());
+	}
+};
+
+TEST_F(Snapshot, empty) {
+	exchange.save(path.c_str());
+	restored.restore(path.c_str());
+	EXPECT_EQ(restored.sequence(), 0);
+}
+
+TEST_F(Snapshot, restore) {
+	exchange.process_request({piex::Request::BUY, 0, 100, 1});
+	exchange.process_request({piex::Request::BUY, 1, 120, 2});
+	exchange.process_request({piex::Request::BUY, 2, 100, 3});
+	exchange.process_request({piex::Request::SELL, 3, 200, 1});
+	exchange.process_request({piex::Request::SELL, 4, 150, 2});
+	exchange.process_request({piex::Request::BUY, 2});
+	exchange.save(path.c_str());
+	restored.restore(path.c_str());
+	EXPECT_EQ(restored.sequence(), 6);
+
+	responses.clear();
+	restored.process_request({piex::Request::SELL, 5, 100, 4});
+	restored.process_request({piex::Request::BUY, 6, 200, 3});
+
+	ASSERT_THAT(responses, testing::ElementsAre(
+		piex::Response::Match(1, 5, 120, 2, 100, 100),
+		piex::Response::Match(0, 5, 100, 1, 0, 100),
+		piex::Response::Place(true, 5),
+		piex::Response::Match(6, 5, 100, 1, 200, 150),
+		piex::Response::Match(6, 4, 150, 2, 0, 200),
+		piex::Response::Place(true, 6)
+	));
+	EXPECT_EQ(restored.sequence(), 8);
+}
+
+TEST_F(Snapshot, scheduler) {
+	{
+		piex::snapshot::Scheduler scheduler;
+		scheduler.enable(path.c_str(), 2);
+		exchange.process_request({piex::Request::BUY, 0, 100, 1});
+		scheduler.poll(exchange);
+		exchange.process_request({piex::Request::BUY, 1, 120, 2});
+		scheduler.poll(exchange);
+		// taken in a forked child: later requests are not in the snapshot
+		exchange.process_request({piex::Request::BUY, 2, 130, 3});
+		scheduler.poll(exchange);
+	}
+	restored.restore(path.c_str());
+	EXPECT_EQ(restored.sequence(), 2);
+
+	responses.clear();
+	restored.process_request({piex::Request::SELL, 3, 100, 3});
+	ASSERT_THAT(responses, testing::ElementsAre(
+		piex::Response::Match(1, 3, 120, 2, 100, 100),
+		piex::Response::Match(0, 3, 100, 1, 0, 0),
+		piex::Response::Place(true, 3)
+	));
+}
+
+TEST_F(Snapshot, invalid) {
+	std::FILE *file = std::fopen(path.c_str(), "w");
+	std::fputs("garbage", file);
+	std::fclose(file);
+	EXPECT_THROW(restored.restore(path.c_str()), std::runtime_error);
+}
+
+TEST_F(Snapshot, market) {
+	piex::Market<Snapshot> market(*this), restored_market(*this);
+	market.process_request(piex::Request::Place{piex::Request::BUY, 0, 100, 1, 1});
+	market.process_request(piex::Request::Place{piex::Request::SELL, 1, 100, 2, 4});
+	market.save(path.c_str());
+	restored_market.restore(path.c_str());
+	EXPECT_EQ(restored_market.sequence(), 2);
+	EXPECT_EQ(restored_market.active_instruments(), 2);
+
+	responses.clear();
+	restored_market.process_request(piex::Request::Place{piex::Request::SELL, 2, 100, 1, 1});
+	restored_market.process_request(piex::Request::Place{piex::Request::BUY, 3, 100, 1, 4});
+
+	ASSERT_THAT(responses, testing::ElementsAre(
+		piex::Response::Match(0, 2, 100, 1, 0, 0, 1),
+		piex::Response::Place(true, 2, 1),
+		piex::Response::Match(3, 1, 100, 1, 0, 100, 4),
+		piex::Response::Place(true, 3, 4)
+	));
+}
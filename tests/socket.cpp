@@ -2,9 +2,13 @@
 #include <utility>
 #include <memory>
 #include <vector>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 #include "gtest/gtest.h"
 #include "tests/config_override.h"
 #include "src/socket/socket.h"
+#include "src/utility/spsc.h"
 
 class Socket : public ::testing::Test {
 protected:
@@ -72,3 +76,98 @@ TEST_F(Socket, batch) {
 		}
 	}
 }
+
+TEST_F(Socket, peek) {
+	#ifdef PIEX_OPTION_SOCKET_BUFFER_SIZE
+		size_t to_transmit = 2 * PIEX_OPTION_SOCKET_BUFFER_SIZE + 10;
+	#else
+		size_t to_transmit = 2 * 4096 + 10;
+	#endif
+	std::vector<unsigned char> data(to_transmit);
+	for (size_t i = 0; i < to_transmit; ++i) {
+		data[i] = i * 7 % 0x100;
+	}
+	for (size_t offset = 0; offset < to_transmit; offset += 16) {
+		client.write(&data[offset], std::min<size_t>(16, to_transmit - offset));
+	}
+	client.flush();
+	// packets of every size up to the limit, so that some of them straddle the end of ring buffers
+	size_t offset = 0;
+	for (size_t size = 1; offset + size <= to_transmit; size = size % piex::utility::socket::PEEK_SIZE + 1) {
+		const void *header = server->peek(1);
+		ASSERT_NE(header, nullptr);
+		ASSERT_EQ(*static_cast<const unsigned char *>(header), data[offset]);
+		const unsigned char *packet = static_cast<const unsigned char *>(server->peek(size));
+		ASSERT_NE(packet, nullptr);
+		ASSERT_TRUE(std::equal(packet, packet + size, &data[offset]));
+		server->consume(size);
+		offset += size;
+	}
+	client.close();
+	if (offset < to_transmit) {
+		ASSERT_NE(server->peek(to_transmit - offset), nullptr);
+		server->consume(to_transmit - offset);
+	}
+	ASSERT_EQ(server->peek(1), nullptr);
+}
+
+#if PIEX_OPTION_SOCKET_FLUSH_LATENCY_USEC > 0
+TEST_F(Socket, flush_threshold) {
+	ASSERT_EQ(server->flush_threshold(), PIEX_OPTION_SOCKET_FLUSH_THRESHOLD);
+	// a few bytes per millisecond is far below the threshold times the latency target
+	char buffer[8] = {};
+	for (int i = 0; i < 20; ++i) {
+		server->write(buffer, sizeof(buffer));
+		server->flush();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	ASSERT_LT(server->flush_threshold(), PIEX_OPTION_SOCKET_FLUSH_THRESHOLD);
+	client.read(buffer, sizeof(buffer));
+}
+#endif
+
+#if PIEX_OPTION_SOCKET_ZEROCOPY_SIZE > 0
+TEST_F(Socket, zerocopy) {
+	// more batches than buffers, so that buffers are reused while the kernel may still hold earlier ones
+	constexpr size_t batches = 16;
+	constexpr size_t size = PIEX_OPTION_SOCKET_ZEROCOPY_SIZE;
+	// zero-copy is enabled on the accepted socket and survives moving it
+	ASSERT_TRUE(client.zerocopy());
+	ASSERT_TRUE(server->zerocopy());
+	std::thread reader([&] {
+		std::vector<unsigned char> buffer(size);
+		for (size_t batch = 0; batch < batches; ++batch) {
+			ASSERT_EQ(client.read(&buffer[0], size), static_cast<int>(size));
+			for (size_t i = 0; i < size; ++i) {
+				ASSERT_EQ(buffer[i], (batch + i) % 0x100);
+			}
+		}
+	});
+	std::vector<unsigned char> data(size);
+	for (size_t batch = 0; batch < batches; ++batch) {
+		for (size_t i = 0; i < size; i += 64) {
+			for (size_t j = 0; j < 64; ++j) {
+				data[j] = (batch + i + j) % 0x100;
+			}
+			server->write(&data[0], 64);
+		}
+		server->flush();
+	}
+	reader.join();
+}
+#endif
+
+TEST(Circular, mirror_fallback) {
+	// smaller than a page, so it cannot be mirrored and copies across its end
+	piex::utility::spsc::Buffer<1024, piex::utility::circular::Mirror<1024>> buffer;
+	std::vector<char> data(1020, 'x');
+	buffer.write(&data[0], data.size());
+	buffer.read(&data[0], data.size());
+	const char packet[] = "split";
+	char out[sizeof(packet)];
+	buffer.write(packet, sizeof(packet));
+	ASSERT_TRUE(buffer.contiguous(4));
+	ASSERT_FALSE(buffer.contiguous(sizeof(packet)));
+	buffer.read(out, sizeof(packet));
+	ASSERT_STREQ(packet, out);
+}
@@ -0,0 +1,113 @@
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/stat.h>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "src/utility/thread.h"
+
+using namespace piex::utility::thread;
+
+TEST(Thread, parse_list) {
+	ASSERT_EQ(parse_list("0-2,5"), std::vector<int>({0, 1, 2, 5}));
+	ASSERT_EQ(parse_list("3"), std::vector<int>({3}));
+	ASSERT_TRUE(parse_list("").empty());
+}
+
+TEST(Thread, topology) {
+	char root[] = "/tmp/piex-topology-XXXXXX";
+	ASSERT_NE(::mkdtemp(root), nullptr);
+	auto write = [&](const std::string &path, const std::string &content) {
+		std::ofstream(std::string(root) + path) << content << std::endl;
+	};
+	write("/online", "0-3");
+	write("/isolated", "2");
+	for (int i = 0; i < 4; ++i) {
+		std::string cpu = std::string(root) + "/cpu" + std::to_string(i);
+		::mkdir(cpu.c_str(), 0700);
+		::mkdir((cpu + "/topology").c_str(), 0700);
+		write("/cpu" + std::to_string(i) + "/topology/physical_package_id", "0");
+		write("/cpu" + std::to_string(i) + "/topology/core_id", std::to_string(i));
+	}
+	std::vector<Cpu> cpus = topology(root);
+	ASSERT_EQ(cpus.size(), 4);
+	ASSERT_TRUE(cpus[2].isolated);
+	ASSERT_FALSE(cpus[3].isolated);
+	ASSERT_EQ(cpus[3].core, 3);
+	std::system((std::string("rm -rf ") + root).c_str());
+}
+
+TEST(Thread, defaults) {
+	// four cores of a Raspberry Pi 3B
+	std::vector<Cpu> cpus = {{0, 0, 0, false}, {1, 0, 1, false}, {2, 0, 2, false}, {3, 0, 3, false}};
+	Affinity affinity = defaults(cpus);
+	ASSERT_EQ(affinity.matching.cpu, 3);
+	ASSERT_EQ(affinity.reader.cpu, 2);
+	ASSERT_EQ(affinity.writer.cpu, 1);
+	// an isolated cpu is reserved for matching
+	cpus[1].isolated = true;
+	affinity = defaults(cpus);
+	ASSERT_EQ(affinity.matching.cpu, 1);
+	ASSERT_EQ(affinity.reader.cpu, 3);
+	ASSERT_EQ(affinity.writer.cpu, 2);
+	// hardware threads of the matching core are left alone
+	cpus = {{0, 0, 0, false}, {1, 0, 1, false}, {2, 0, 0, false}, {3, 0, 1, false}};
+	affinity = defaults(cpus);
+	ASSERT_EQ(affinity.matching.cpu, 3);
+	ASSERT_EQ(affinity.reader.cpu, 2);
+	ASSERT_EQ(affinity.writer.cpu, 0);
+	ASSERT_EQ(defaults({{0, 0, 0, false}}).matching.cpu, -1);
+}
+
+TEST(Thread, parse) {
+	std::vector<Cpu> cpus = {{0, 0, 0, false}, {1, 0, 1, false}, {2, 0, 2, false}, {3, 0, 3, false}};
+	Affinity affinity = parse("auto,matching=0:80,writer=-1", cpus);
+	ASSERT_EQ(affinity.matching.cpu, 0);
+	ASSERT_EQ(affinity.matching.priority, 80);
+	ASSERT_EQ(affinity.reader.cpu, 2);
+	ASSERT_EQ(affinity.reader.priority, 0);
+	ASSERT_EQ(affinity.writer.cpu, -1);
+	ASSERT_EQ(parse("", cpus).matching.cpu, -1);
+	ASSERT_THROW(parse("matcher=1", cpus), std::runtime_error);
+	ASSERT_THROW(parse("reader=x", cpus), std::runtime_error);
+	ASSERT_THROW(parse("reader=1:", cpus), std::runtime_error);
+	ASSERT_THROW(parse("writer=4", cpus), std::runtime_error);
+}
+
+TEST(Thread, spawn) {
+	// a thread left to the scheduler does not inherit the cpu its creator is pinned to
+	pthread_t self = pthread_self();
+	int cpu = 0;
+	while (!CPU_ISSET(cpu, &INITIAL_CPUS)) {
+		++cpu;
+	}
+	pin(self, cpu);
+	cpu_set_t set, pinned;
+	spawn({}, [&] {
+		pthread_getaffinity_np(pthread_self(), sizeof(set), &set);
+	}).join();
+	spawn({cpu, 0}, [&] {
+		pthread_getaffinity_np(pthread_self(), sizeof(pinned), &pinned);
+	}).join();
+	pthread_setaffinity_np(self, sizeof(INITIAL_CPUS), &INITIAL_CPUS);
+	ASSERT_TRUE(CPU_EQUAL(&set, &INITIAL_CPUS));
+	ASSERT_EQ(CPU_COUNT(&pinned), 1);
+	ASSERT_TRUE(CPU_ISSET(cpu, &pinned));
+}
+
+TEST(Thread, spread) {
+	std::vector<Cpu> cpus = {{0, 0, 0, false}, {1, 0, 1, false}, {2, 0, 2, false}, {3, 0, 3, false}};
+	std::vector<Placement> placements = spread({2, 80}, 3, {0}, cpus);
+	ASSERT_EQ(placements.size(), 3);
+	ASSERT_EQ(placements[0].cpu, 2);
+	ASSERT_EQ(placements[1].cpu, 3);
+	// wraps around, skipping the cpus of other threads
+	ASSERT_EQ(placements[2].cpu, 1);
+	ASSERT_EQ(placements[2].priority, 80);
+	ASSERT_EQ(spread({-1, 0}, 4, {}, cpus)[3].cpu, -1);
+	ASSERT_THROW(spread({3, 0}, 4, {1}, cpus), std::runtime_error);
+	ASSERT_THROW(spread({4, 0}, 1, {}, cpus), std::runtime_error);
+}
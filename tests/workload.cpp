@@ -0,0 +1,128 @@
+#include <unistd.h>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <variant>
+#include <algorithm>
+#include <stdexcept>
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "tests/config_override.h"
+#include "src/packets/packets.h"
+#include "benchmark/workload.h"
+#include "benchmark/source/file.h"
+#include "benchmark/generate.h"
+
+class Workload : public testing::Test {
+public:
+	void process(const piex::Request::Place &request) {
+		requests.emplace_back(request);
+	}
+	void process(const piex::Request::Cancel &request) {
+		requests.emplace_back(request);
+	}
+protected:
+	static piex::Order::IdType id_of(const piex::Request::Place &request) {
+		return request.order().id();
+	}
+	static piex::Order::IdType id_of(const piex::Request::Cancel &request) {
+		return request.id();
+	}
+	std::vector<std::variant<piex::Request::Place, piex::Request::Cancel>> requests;
+	std::string path = "/tmp/piex-workload-" + std::to_string(::getpid());
+	virtual void TearDown() {
+		std::remove(path.c_str());
+	}
+};
+
+TEST_F(Workload, replay) {
+	{
+		piex::benchmark::workload::Writer writer(path.c_str(), {7, 1000, 2});
+		writer.append(piex::Request::Place(piex::Request::BUY, 0, 100, 1, 1));
+		writer.append(piex::Request::Cancel(piex::Request::BUY, 0, 1));
+		writer.append(piex::Request::Place(piex::Request::SELL, 1, 200, 3));
+		writer.flush();
+	}
+	piex::benchmark::source::File<Workload> source(*this, path);
+	EXPECT_EQ(source.header().count, 3);
+	EXPECT_EQ(source.header().seed, 7);
+	EXPECT_EQ(source.header().book_size, 1000);
+	EXPECT_EQ(source.header().instruments, 2);
+	for (int i = 0; i < 3; ++i) {
+		source.yield();
+	}
+	ASSERT_THAT(requests, testing::ElementsAre(
+		piex::Request::Place(piex::Request::BUY, 0, 100, 1, 1),
+		piex::Request::Cancel(piex::Request::BUY, 0, 1),
+		piex::Request::Place(piex::Request::SELL, 1, 200, 3)
+	));
+	ASSERT_THROW(source.yield(), std::out_of_range);
+}
+
+TEST_F(Workload, unflushed) {
+	piex::benchmark::workload::Writer writer(path.c_str(), {0, 0, 1});
+	writer.append(piex::Request::Place(piex::Request::BUY, 0, 100, 1));
+	writer.flush();
+	writer.append(piex::Request::Place(piex::Request::BUY, 1, 100, 1));
+	piex::benchmark::workload::Mapping mapping(path.c_str());
+	EXPECT_EQ(mapping.header().count, 1);
+	EXPECT_EQ(mapping.end() - mapping.begin(), sizeof(piex::Request::Place));
+}
+
+TEST_F(Workload, mismatch) {
+	{
+		piex::benchmark::workload::Writer writer(path.c_str(), {0, 0, 1});
+	}
+	{
+		FILE *file = std::fopen(path.c_str(), "r+b");
+		std::uint32_t version = piex::benchmark::workload::VERSION + 1;
+		std::fseek(file, offsetof(piex::benchmark::workload::Header, version), SEEK_SET);
+		std::fwrite(&version, sizeof(version), 1, file);
+		std::fclose(file);
+	}
+	ASSERT_THROW(piex::benchmark::workload::Mapping(path.c_str()), std::runtime_error);
+	::truncate(path.c_str(), 8);
+	ASSERT_THROW(piex::benchmark::workload::Mapping(path.c_str()), std::runtime_error);
+}
+
+TEST_F(Workload, generate) {
+	std::string other = path + "-other";
+	piex::benchmark::generate::generate(path.c_str(), 1000, 5, 1000, 42, 3);
+	piex::benchmark::generate::generate(other.c_str(), 1000, 5, 1000, 42, 3);
+	std::ifstream a(path, std::ios::binary), b(other, std::ios::binary);
+	ASSERT_TRUE(std::equal(std::istreambuf_iterator<char>(a), {}, std::istreambuf_iterator<char>(b), {}));
+	std::remove(other.c_str());
+
+	piex::benchmark::source::File<Workload> source(*this, path);
+	EXPECT_EQ(source.header().count, 1000);
+	EXPECT_EQ(source.header().shards, 3);
+	for (int i = 0; i < 1000; ++i) {
+		source.yield();
+	}
+	ASSERT_THROW(source.yield(), std::out_of_range);
+	// blocks of requests of shard k = i / 64 % 3 hold its instruments and ids only
+	for (std::size_t i = 0; i < requests.size(); ++i) {
+		std::uint64_t shard = i / piex::benchmark::generate::SHARD_BLOCK_SIZE % 3;
+		std::visit([&](const auto &request) {
+			EXPECT_EQ(request.instrument() % 3, shard);
+			EXPECT_EQ(id_of(request) / 1000, shard);
+		}, requests[i]);
+	}
+}
+
+TEST_F(Workload, profile) {
+	piex::benchmark::generate::generate(path.c_str(), 1000, 4, 100000, 0, 1, piex::benchmark::source::profile("hft"));
+	piex::benchmark::source::File<Workload> source(*this, path);
+	for (int i = 0; i < 100000; ++i) {
+		source.yield();
+	}
+	std::size_t cancels = std::count_if(requests.begin(), requests.end(), [](const auto &request) {
+		return std::holds_alternative<piex::Request::Cancel>(request);
+	});
+	// most orders placed are cancelled
+	EXPECT_GT(cancels, (requests.size() - cancels) * 9 / 10);
+	ASSERT_THROW(piex::benchmark::source::profile("unknown"), std::invalid_argument);
+}